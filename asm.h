@@ -10,5 +10,7 @@ uint32_t* getPSP(void);
 uint32_t* getMSP(void);
 void pushRegs(void);
 void popRegs(void);
+uint32_t getClz(uint32_t x);
+uint32_t setBasepri(uint32_t mask);
 
 #endif /* PSP_STACK_H_ */
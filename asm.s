@@ -5,6 +5,8 @@
 	.def setTMPL
 	.def pushRegs
 	.def popRegs
+	.def getClz
+	.def setBasepri
 
 .thumb
 .const
@@ -66,4 +68,15 @@ popRegs:
 	LDR R4,[R0],#4
 	MSR PSP,R0
 	BX LR
+
+getClz:
+	CLZ R0, R0			;count leading zeros, 32 if R0 is 0
+	BX LR
+
+setBasepri:
+	MRS R1, BASEPRI		;previous mask returned in R0
+	MSR BASEPRI, R0
+	ISB
+	MOV R0, R1
+	BX LR
 endm
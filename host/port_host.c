@@ -0,0 +1,336 @@
+// Port layer functions for the Linux host simulation
+//
+// Tasks run as ucontext coroutines on their own host stacks, the kernel
+// handlers run on the stack of the interrupted task like they do on the
+// core. SIGALRM stands in for the SysTick and blocking it masks the
+// "interrupts" while a service call or task switch is in progress.
+//
+// The simulated SRAM (32 KiB) and System Control Space page are mapped at
+// their TM4C123 addresses, so mm.c hands out the same heap addresses and
+// its MPU register writes land in ordinary memory.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifdef HOST_SIM
+
+#define _GNU_SOURCE
+#define sleep unistdSleep                   // the kernel's sleep(ticks) takes the name
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#undef sleep
+#include "../port.h"
+#include "../kernel.h"
+
+#define SRAM_BASE       0x20000000
+#define SRAM_SIZE       0x8000
+#define SCS_BASE        0xE000E000
+#define SCS_SIZE        0x1000
+#define HOST_STACK_SIZE 0x10000             // host code needs far more stack than the target tasks
+#define CYCLES_PER_US   40
+
+volatile bool portSwitchPending = false;
+
+uint64_t portEpoch = 0;                     // ns at portInit
+uint32_t portRunStart = 0;                  // cycle count when the run timer was restarted
+uint32_t portReload = 0;                    // systick reload value in cycles
+uint32_t portTickStart = 0;                 // cycle count when the systick period was programmed
+
+uint32_t *portPsp = NULL;                   // stacked frame of an svc in progress, otherwise the running context
+uint32_t *portFrom = NULL;                  // context being switched out by pendSvIsr
+ucontext_t portContext[MAX_TASKS];
+uint8_t *portStack[MAX_TASKS];
+uint32_t *portFrame[MAX_TASKS];             // frame of the svc each task last made, it returns stacked R0
+void (*portEntry[MAX_TASKS])();             // task function, entered through portTaskEntry
+
+uint8_t portSvcCode[2 * 256 + 2];           // SVC #n instructions, svCallIsr reads n from the stacked pc
+
+uint32_t portBasepri = 0;
+sigset_t portBasepriMask;                   // signal mask before BASEPRI was raised
+uint8_t portHandlerDepth = 0;               // nested svc and tick handlers, they already run with the tick masked
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void portMap(uint32_t base, uint32_t size)
+{
+    void *p = mmap((void*)(uintptr_t)base, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if(p != (void*)(uintptr_t)base)
+    {
+        fprintf(stderr, "port: cannot map 0x%08X\n", base);
+        exit(1);
+    }
+}
+
+// pend the switch the kernel asked for, runs in handler context
+void portDispatch(void)
+{
+    if(portSwitchPending)
+    {
+        portSwitchPending = false;
+        pendSvIsr();
+    }
+}
+
+void portTickIsr(int sig)
+{
+    portHandlerDepth++;
+    systickIsr();
+    portDispatch();
+    portHandlerDepth--;
+}
+
+void portMaskTicks(sigset_t *old)
+{
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGALRM);
+    sigprocmask(SIG_BLOCK, &set, old);
+}
+
+// map the target memory, install the tick handler and keep it masked until startRtos
+void portInit(void)
+{
+    struct sigaction sa;
+    struct timespec ts;
+    uint32_t n;
+    portMap(SRAM_BASE, SRAM_SIZE);
+    portMap(SCS_BASE, SCS_SIZE);
+    for(n = 0; n < 256; n++)
+    {
+        portSvcCode[2 * n] = n;             // little endian 0xDFnn
+        portSvcCode[2 * n + 1] = 0xDF;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    portEpoch = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    portMaskTicks(NULL);
+    sa.sa_handler = portTickIsr;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGALRM, &sa, NULL);
+}
+
+// 40 MHz cycle count since portInit
+uint32_t portCycles(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t ns = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec - portEpoch;
+    return (uint32_t)(ns * CYCLES_PER_US / 1000);
+}
+
+uint32_t portRunTime(void)
+{
+    return portCycles() - portRunStart;
+}
+
+void portRunRestart(void)
+{
+    portRunStart = portCycles();
+}
+
+// one signal stands in for every interrupt, nothing to prioritize
+void portPrioritiesInit(void)
+{
+}
+
+// systick model: counts down from portReload to 0 and reloads
+void portTimersInit(uint32_t tickReload)
+{
+    portRunRestart();
+    portTickSet(tickReload);
+}
+
+uint32_t portTickReload(void)
+{
+    return portReload;
+}
+
+uint32_t portTickCurrent(void)
+{
+    return portReload - (portCycles() - portTickStart) % (portReload + 1);
+}
+
+// the period expired but its interrupt has not been taken yet
+bool portTickWrapped(void)
+{
+    sigset_t set;
+    sigpending(&set);
+    return sigismember(&set, SIGALRM);
+}
+
+void portTickClearPending(void)
+{
+    sigset_t set;
+    struct timespec zero = {0, 0};
+    sigemptyset(&set);
+    sigaddset(&set, SIGALRM);
+    sigtimedwait(&set, NULL, &zero);
+}
+
+void portTickSet(uint32_t reload)
+{
+    struct itimerval it;
+    uint32_t us = (reload + 1) / CYCLES_PER_US;
+    if(us == 0)
+        us = 1;
+    portReload = reload;
+    portTickStart = portCycles();
+    it.it_value.tv_sec = us / 1000000;
+    it.it_value.tv_usec = us % 1000000;
+    it.it_interval = it.it_value;
+    setitimer(ITIMER_REAL, &it, NULL);
+    portTickClearPending();                 //expiries of the old period raced in by signal latency, ticks are masked here
+}
+
+void portTraceTimerInit(void)
+{
+}
+
+// a task starts in thread mode, even when pendSvIsr dispatched it from inside a handler
+void portTaskEntry(void)
+{
+    portHandlerDepth = 0;
+    portEntry[taskCurrent]();
+}
+
+// a fresh context for the task being dispatched, entered at fn with ticks unmasked
+void *portStackInit(void *sp, void (*fn)())
+{
+    uint8_t task = taskCurrent;
+    if(portStack[task] == NULL)
+    {
+        portStack[task] = mmap(NULL, HOST_STACK_SIZE, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+        if(portStack[task] == MAP_FAILED)
+        {
+            fprintf(stderr, "port: no stack for task %u\n", task);
+            exit(1);
+        }
+    }
+    getcontext(&portContext[task]);
+    portContext[task].uc_stack.ss_sp = portStack[task];
+    portContext[task].uc_stack.ss_size = HOST_STACK_SIZE;
+    portContext[task].uc_link = NULL;
+    sigemptyset(&portContext[task].uc_sigmask);
+    portEntry[task] = fn;
+    makecontext(&portContext[task], portTaskEntry, 0);
+    return &portContext[task];
+}
+
+void portStart(void *sp, void (*fn)())
+{
+    portPsp = portStackInit(sp, fn);
+    portRunRestart();
+    setcontext((ucontext_t*)portPsp);
+}
+
+// service call: stack an exception frame, run the handler, then any pending switch
+uint32_t portSvc(uint8_t n, uint32_t r0, uint32_t r1, uint32_t r2, uint32_t r3)
+{
+    sigset_t old;
+    uint32_t frame[8];
+    uint32_t *running;
+    portMaskTicks(&old);
+    frame[0] = r0;
+    frame[1] = r1;
+    frame[2] = r2;
+    frame[3] = r3;
+    frame[4] = 0;
+    frame[5] = 0;
+    frame[6] = (uint32_t)(uintptr_t)&portSvcCode[2 * n + 2];
+    frame[7] = 0x01000000;
+    running = portPsp;
+    if(running != NULL)                     //NULL for calls made from main before startRtos
+        portFrame[(ucontext_t*)running - portContext] = frame;
+    portPsp = frame;
+    portHandlerDepth++;
+    svCallIsr();
+    portPsp = running;
+    portDispatch();
+    portHandlerDepth--;
+    sigprocmask(SIG_SETMASK, &old, NULL);
+    return frame[0];
+}
+
+// sp is the context of a task switched out inside portSvc, its frame is still on that task's stack
+void portSetResult(void *sp, uint32_t value)
+{
+    portFrame[(ucontext_t*)sp - portContext][0] = value;
+}
+
+void portSetResultCurrent(uint32_t value)
+{
+    portFrame[taskCurrent][0] = value;
+}
+
+void portReset(void)
+{
+    printf("\nreset\n");
+    exit(0);
+}
+
+// asm.s replacements, the process stack pointer is the running task's context
+void setASP(void)
+{
+}
+
+void setTMPL(int x)
+{
+}
+
+void setPSP(uint32_t* p)
+{
+    portPsp = p;
+}
+
+uint32_t* getPSP(void)
+{
+    return portPsp;
+}
+
+uint32_t* getMSP(void)
+{
+    return NULL;
+}
+
+void pushRegs(void)
+{
+    portFrom = portPsp;
+}
+
+void popRegs(void)
+{
+    if(portPsp != portFrom)
+        swapcontext((ucontext_t*)portFrom, (ucontext_t*)portPsp);
+}
+
+uint32_t getClz(uint32_t x)
+{
+    return (x == 0) ? 32 : __builtin_clz(x);
+}
+
+// the tick is masked while BASEPRI is raised, as the systick is on the core
+// inside a handler it is masked already
+uint32_t setBasepri(uint32_t mask)
+{
+    uint32_t old = portBasepri;
+    if(portHandlerDepth == 0 && old == 0 && mask != 0)
+        portMaskTicks(&portBasepriMask);
+    else if(portHandlerDepth == 0 && old != 0 && mask == 0)
+        sigprocmask(SIG_SETMASK, &portBasepriMask, NULL);
+    portBasepri = mask;
+    return old;
+}
+
+#endif
@@ -0,0 +1,632 @@
+// RTOS host simulation
+// Runs the kernel, memory manager and shell as a Linux process
+//
+// Build (from the repository root):
+//   gcc -DHOST_SIM -no-pie -fcommon -O2 -o rtos_sim kernel.c mm.c trace.c ring.c shell.c shell_func.c host/*.c
+// Run:
+//   ./rtos_sim            shell on the terminal
+//   ./rtos_sim bench      semaphore ping-pong benchmark
+//   ./rtos_sim notify     the same ping-pong with task notifications
+//   ./rtos_sim pi         lock latency of Important behind LengthyFn with pi off and on
+//   ./rtos_sim queue      message queue and mailbox producer/consumer throughput
+//   ./rtos_sim ring       ring buffer stream checked for order across buffer and index wraparound
+//   ./rtos_sim timeout    waitTimeout and lockTimeout racing a post or unlock, exits 1 on a failure
+//   ./rtos_sim dispatch   rtosScheduler cost at 12, 64 and 255 tasks against the old nested scan
+//   ./rtos_sim tick       systickIsr cost with 8, 32 and 128 sleepers against the old scanning isr
+//
+// dispatch and tick need more tasks than the target has, build them with -DMAX_TASKS=255
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifdef HOST_SIM
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../port.h"
+#include "../mm.h"
+#include "../kernel.h"
+#include "../uart0.h"
+#include "../shell.h"
+#include "../shell_func.h"
+#include "../ring.h"
+
+#define BENCH_ROUNDS 200000
+#define PI_ROUNDS    20
+#define QUEUE_DEPTH  8
+#define RECORD_SIZE  16
+#define MAIL_BYTES   1024
+#define DISPATCH_ROUNDS 1000000
+#define TICK_ROUNDS  1000000
+#define RING_SIZE    64
+#define RING_BYTES   1000000
+#define RING_CHUNK   37                     // largest write or read, prime so the chunks drift around the ring
+#define RACE_TIMEOUT 10                     // ticks waitTimeout and lockTimeout give up after in the timeout test
+
+// kernel state the benchmarks set up directly, they run from main without starting the kernel
+extern bool priorityScheduler;
+extern bool preemption;
+extern bool pingpong;
+extern uint32_t tickTime;
+
+//-----------------------------------------------------------------------------
+// Tasks
+//-----------------------------------------------------------------------------
+
+void idle(void)
+{
+    while(true)
+    {
+        yield();
+    }
+}
+
+void printTrips(uint32_t start)
+{
+    uint32_t us = (portCycles() - start) / 40;
+    putsUart0("round trips: ");
+    intToString(BENCH_ROUNDS);
+    putsUart0("\ntime (us):   ");
+    intToString(us);
+    putsUart0("\nns per trip: ");
+    intToString((uint64_t)us * 1000 / BENCH_ROUNDS);
+    putsUart0("\n");
+    reboot();
+}
+
+// post/wait round trips between two tasks, each one costs two service calls and two switches
+void ping(void)
+{
+    uint32_t i;
+    uint32_t start = portCycles();
+    for(i = 0; i < BENCH_ROUNDS; i++)
+    {
+        post(keyPressed);
+        wait(keyReleased);
+    }
+    printTrips(start);
+}
+
+void pong(void)
+{
+    while(true)
+    {
+        wait(keyPressed);
+        post(keyReleased);
+    }
+}
+
+// the same round trips through the tasks' notification words
+void notifyPong(void);
+
+void notifyPing(void)
+{
+    uint32_t i;
+    uint32_t start = portCycles();
+    for(i = 0; i < BENCH_ROUNDS; i++)
+    {
+        notify(notifyPong, 0, NOTIFY_INCREMENT);
+        takeNotify(true, WAIT_FOREVER);
+    }
+    printTrips(start);
+}
+
+void notifyPong(void)
+{
+    while(true)
+    {
+        takeNotify(true, WAIT_FOREVER);
+        notify(notifyPing, 0, NOTIFY_INCREMENT);
+    }
+}
+
+// busy for ms like the demo tasks, without giving up the cpu
+void spin(uint32_t ms)
+{
+    uint32_t start = portCycles();
+    while(portCycles() - start < ms * 40000);
+}
+
+// low priority owner of resource with long critical sections
+void lengthyFn(void)
+{
+    while(true)
+    {
+        lock(resource);
+        spin(5);
+        unlock(resource);
+        yield();
+    }
+}
+
+// medium priority cpu hog that preempts LengthyFn while it holds resource
+void hog(void)
+{
+    while(true)
+    {
+        spin(30);
+        sleep(20);
+    }
+}
+
+// worst and average wait of lock(resource) over PI_ROUNDS tries
+void lockLatency(void)
+{
+    uint32_t i, wait, worst = 0, total = 0;
+    for(i = 0; i < PI_ROUNDS; i++)
+    {
+        sleep(7);
+        uint32_t start = portCycles();
+        lock(resource);
+        wait = (portCycles() - start) / 40;
+        unlock(resource);
+        total += wait;
+        if(wait > worst)
+            worst = wait;
+    }
+    putsUart0("lock wait (us): worst ");
+    intToString(worst);
+    putsUart0(", average ");
+    intToString(total / PI_ROUNDS);
+    putsUart0("\n");
+}
+
+void important(void)
+{
+    sched(SCHED_PRIO);
+    preempt(true);
+    pi(false);
+    lockLatency();
+    pi(true);
+    lockLatency();
+    reboot();
+}
+
+// messages per second through queue 0 (words), queue 1 (RECORD_SIZE byte records)
+// and mailbox 2 (MAIL_BYTES buffers passed by ownership)
+void printRate(char *what, uint32_t start)
+{
+    uint32_t us = (portCycles() - start) / 40;
+    putsUart0(what);
+    intToString((uint64_t)BENCH_ROUNDS * 1000000 / us);
+    putsUart0(" messages/s\n");
+}
+
+void producer(void)
+{
+    uint32_t i;
+    uint8_t record[RECORD_SIZE] = {0};
+    for(i = 0; i < BENCH_ROUNDS; i++)
+    {
+        sendWord(0, i, WAIT_FOREVER);
+    }
+    for(i = 0; i < BENCH_ROUNDS; i++)
+    {
+        record[0] = i;
+        sendMessage(1, record, WAIT_FOREVER);
+    }
+    for(i = 0; i < BENCH_ROUNDS; i++)
+    {
+        uint32_t *mail;
+        do
+        {
+            mail = allocMail(MAIL_BYTES);           //the consumer frees the last one
+        } while(mail == NULL);
+        mail[0] = i;
+        sendMail(2, mail, WAIT_FOREVER);
+    }
+    while(true)
+    {
+        sleep(1000);
+    }
+}
+
+void consumer(void)
+{
+    uint32_t i, word, start;
+    uint8_t record[RECORD_SIZE];
+    uint32_t *mail;
+    start = portCycles();
+    for(i = 0; i < BENCH_ROUNDS; i++)
+    {
+        receiveMessage(0, &word, WAIT_FOREVER);
+        if(word != i)
+            putsUart0("out of order\n");
+    }
+    printRate("word:   ", start);
+    start = portCycles();
+    for(i = 0; i < BENCH_ROUNDS; i++)
+    {
+        receiveMessage(1, record, WAIT_FOREVER);
+    }
+    printRate("record: ", start);
+    start = portCycles();
+    for(i = 0; i < BENCH_ROUNDS; i++)
+    {
+        receiveMail(2, (void**)&mail, WAIT_FOREVER);
+        if(mail[0] != i)
+            putsUart0("out of order\n");
+        freeMail(mail);
+    }
+    printRate("mail:   ", start);
+    reboot();
+}
+
+// a byte stream through a ring buffer, RingWriter stands in for an interrupt handler
+// the indexes start just below 2^32 so head and tail wrap as well as the buffer
+RING_BUFFER ring;
+uint8_t ringStorage[RING_SIZE];
+
+void ringWriter(void)
+{
+    uint8_t chunk[RING_CHUNK];
+    uint32_t sent = 0, length, n, i;
+    while(sent < RING_BYTES)
+    {
+        length = 1 + sent % RING_CHUNK;
+        if(length > RING_BYTES - sent)
+            length = RING_BYTES - sent;
+        for(i = 0; i < length; i++)
+            chunk[i] = sent + i;
+        n = 0;
+        while(n < length)
+        {
+            n += ringWrite(&ring, &chunk[n], length - n);
+            yield();                            //let the reader drain at every fill level
+        }
+        sent += length;
+    }
+    while(true)
+    {
+        sleep(1000);
+    }
+}
+
+void ringReader(void)
+{
+    uint8_t chunk[RING_CHUNK];
+    uint32_t received = 0, errors = 0, n, i;
+    uint32_t start = portCycles();
+    while(received < RING_BYTES)
+    {
+        n = ringReadWait(&ring, chunk, 1 + received % RING_CHUNK, WAIT_FOREVER);
+        for(i = 0; i < n; i++)
+        {
+            if(chunk[i] != (uint8_t)(received + i))
+                errors++;
+        }
+        received += n;
+    }
+    putsUart0("bytes:        ");
+    intToString(RING_BYTES);
+    putsUart0("\ntime (us):    ");
+    intToString((portCycles() - start) / 40);
+    putsUart0("\nout of order: ");
+    intToString(errors);
+    putsUart0("\nhead:         ");
+    intToString(ring.head);                 //wrapped past 2^32
+    putsUart0("\n");
+    reboot();
+}
+
+// timeouts racing a post or unlock: Releaser posts keyPressed or unlocks resource raceAfter ticks
+// after TimeoutTest starts waitTimeout or lockTimeout on it, before, at and after RACE_TIMEOUT
+// the wait must return true at raceAfter or false at RACE_TIMEOUT, and the release is taken exactly
+// once, by the wait or by the non-blocking retry after it
+uint32_t raceAfter;
+bool raceMutex;
+
+void releaser(void)
+{
+    while(true)
+    {
+        wait(keyReleased);
+        if(raceMutex)
+            lock(resource);
+        sleep(raceAfter);
+        if(raceMutex)
+            unlock(resource);
+        else
+            post(keyPressed);
+    }
+}
+
+// returns true if the round behaved
+bool raceRound(bool mutex, uint32_t after)
+{
+    uint32_t start, at;
+    bool got, retry;
+    raceMutex = mutex;
+    raceAfter = after;
+    sleep(1);                               //start on a tick boundary
+    start = tickTime;
+    post(keyReleased);                      //Releaser runs now, its sleep starts this tick too
+    got = mutex ? lockTimeout(resource, RACE_TIMEOUT) : waitTimeout(keyPressed, RACE_TIMEOUT);
+    at = tickTime - start;
+    sleep(RACE_TIMEOUT);                    //a release after the timeout has happened by now
+    retry = mutex ? lockTimeout(resource, 0) : waitTimeout(keyPressed, 0);
+    if(mutex && (got || retry))
+        unlock(resource);
+
+    putsUart0(mutex ? "lockTimeout" : "waitTimeout");
+    putsUart0(", released at ");
+    intToString(after);
+    putsUart0(got ? ": true at " : ": false at ");
+    intToString(at);
+    putsUart0(retry ? ", retry true\n" : ", retry false\n");
+
+    if(got == retry)
+        return false;                       //lost or taken twice
+    if(got)
+        return after <= RACE_TIMEOUT && at == after;
+    return after >= RACE_TIMEOUT && at == RACE_TIMEOUT;
+}
+
+void timeoutTest(void)
+{
+    const uint32_t afters[] = {5, RACE_TIMEOUT - 1, RACE_TIMEOUT, RACE_TIMEOUT + 1, 2 * RACE_TIMEOUT - 1};
+    uint32_t i, failed = 0;
+    sched(SCHED_PRIO);
+    preempt(true);
+    for(i = 0; i < sizeof(afters) / sizeof(afters[0]); i++)
+    {
+        failed += !raceRound(false, afters[i]);
+        failed += !raceRound(true, afters[i]);
+    }
+    putsUart0(failed ? "timeout: FAILED\n" : "timeout: passed\n");
+    exit(failed ? 1 : 0);
+}
+
+// the scheduler rtosScheduler replaced: scan every priority for a ready or unrun task
+// count stands in for both MAX_TASKS and taskCount, as if the kernel was built for that many tasks
+uint8_t legacyNext[8];
+
+uint8_t legacyScheduler(uint8_t count)
+{
+    uint8_t prio, task, i;
+    for(prio = 0; prio < 8; prio++)
+    {
+        task = legacyNext[prio];
+        for(i = 0; i < count; i++)
+        {
+            if((tcb[task].state == 2 || tcb[task].state == 1) && tcb[task].currentPriority == prio)
+            {
+                legacyNext[prio] = (task + 1) % count;
+                return task;
+            }
+            task = (task + 1) % count;
+        }
+    }
+    return 0;
+}
+
+// count tasks, all blocked (state 4) at priorities 0-6 but the last, which is ready at 7 like idle
+// returns ns per pick of the old scan and of rtosScheduler
+void dispatchRun(uint8_t count)
+{
+    volatile uint8_t sink;
+    uint32_t i, start, legacy, ready;
+    initRtos();
+    priorityScheduler = true;
+    for(i = 0; i < count; i++)
+    {
+        tcb[i].priority = tcb[i].currentPriority = (i == count - 1) ? 7 : i % 7;
+        tcb[i].state = 4;
+    }
+    tcb[count - 1].state = 2;
+    readyInsert(count - 1);
+    taskCount = count;
+    for(i = 0; i < 8; i++)
+        legacyNext[i] = 0;
+
+    start = portCycles();
+    for(i = 0; i < DISPATCH_ROUNDS; i++)
+        sink = legacyScheduler(count);
+    legacy = portCycles() - start;
+    start = portCycles();
+    for(i = 0; i < DISPATCH_ROUNDS; i++)
+        sink = rtosScheduler();
+    ready = portCycles() - start;
+    (void)sink;
+
+    intToString(count);
+    putsUart0(" tasks: scan ");
+    intToString((uint64_t)legacy * 25 / DISPATCH_ROUNDS);
+    putsUart0(" ns, bitmap ");
+    intToString((uint64_t)ready * 25 / DISPATCH_ROUNDS);
+    putsUart0(" ns\n");
+}
+
+void dispatchBench(void)
+{
+    const uint8_t counts[] = {12, 64, 255};
+    uint8_t i;
+    for(i = 0; i < sizeof(counts); i++)
+    {
+        if(counts[i] <= MAX_TASKS)
+        {
+            dispatchRun(counts[i]);
+        }
+        else
+        {
+            intToString(counts[i]);
+            putsUart0(" tasks: skipped, build with -DMAX_TASKS=255\n");
+        }
+    }
+}
+
+// the systickIsr the delta queue replaced: count down every delayed task (state 3), swap the
+// ps window and request a switch every tick (its priority inheritance poll is left out, pi is off here)
+// the sleep counts are kept in their own array so the delta queue of the kernel is left alone
+uint32_t legacyTicks[MAX_TASKS];
+uint32_t legacyTime = 0;
+
+void legacySystickIsr(void)
+{
+    uint8_t i;
+    for(i = 0; i < taskCount; i++)
+    {
+        if(tcb[i].state == 3)
+        {
+            legacyTicks[i]--;
+            if(legacyTicks[i] == 0)
+                tcb[i].state = 2;
+        }
+    }
+    legacyTime++;
+    if(legacyTime > 500)
+    {
+        legacyTime = 0;
+        pingpong = !pingpong;
+        for(i = 0; i < taskCount; i++)
+        {
+            if(pingpong)
+                tcb[i].timeA = 0;
+            else
+                tcb[i].timeB = 0;
+        }
+    }
+    if(preemption)
+    {
+        PORT_PEND_SWITCH();
+    }
+}
+
+// sleepers delayed tasks that never wake during the run, plus a ready task at 7 that is running
+// both isrs are timed whole, so the new one pays for time slices and the reschedule check too
+void tickRun(uint8_t sleepers)
+{
+    uint32_t i, start, legacy, delta;
+    initRtos();
+    priorityScheduler = true;
+    preemption = true;
+    for(i = 0; i < sleepers; i++)
+    {
+        tcb[i].priority = tcb[i].currentPriority = i % 7;
+        tcb[i].state = 3;
+        legacyTicks[i] = 2 * TICK_ROUNDS + i;
+        sleepInsert(i, 2 * TICK_ROUNDS + i);
+    }
+    tcb[sleepers].priority = tcb[sleepers].currentPriority = 7;
+    tcb[sleepers].state = 2;
+    readyInsert(sleepers);
+    taskCurrent = sleepers;
+    taskCount = sleepers + 1;
+
+    start = portCycles();
+    for(i = 0; i < TICK_ROUNDS; i++)
+        legacySystickIsr();
+    legacy = portCycles() - start;
+    start = portCycles();
+    for(i = 0; i < TICK_ROUNDS; i++)
+        systickIsr();
+    delta = portCycles() - start;
+
+    intToString(sleepers);
+    putsUart0(" sleepers: old isr ");
+    intToString((uint64_t)legacy * 25 / TICK_ROUNDS);
+    putsUart0(" ns, delta queue isr ");
+    intToString((uint64_t)delta * 25 / TICK_ROUNDS);
+    putsUart0(" ns\n");
+}
+
+void tickBench(void)
+{
+    const uint8_t counts[] = {8, 32, 128};
+    uint8_t i;
+    for(i = 0; i < sizeof(counts); i++)
+    {
+        if(counts[i] < MAX_TASKS)
+        {
+            tickRun(counts[i]);
+        }
+        else
+        {
+            intToString(counts[i]);
+            putsUart0(" sleepers: skipped, build with -DMAX_TASKS=255\n");
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Main
+//-----------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    bool ok;
+
+    portInit();
+    initMemoryManager();
+    initRtos();
+    initMpu();
+
+    initMutex(resource);
+    initSemaphore(keyPressed, 0);
+    initSemaphore(keyReleased, 0);
+    initSemaphore(flashReq, 5);
+    initMsgQueue(0, QUEUE_DEPTH, sizeof(uint32_t));
+    initMsgQueue(1, QUEUE_DEPTH, RECORD_SIZE);
+    initMailbox(2, QUEUE_DEPTH);
+    initEventGroup(0);
+    initRing(&ring, ringStorage, RING_SIZE);
+    ring.head = ring.tail = 0xFFFFFFFF - RING_BYTES / 2;
+    ringNotify(&ring, 0, 1);
+
+    if(argc > 1 && strcmp(argv[1], "dispatch") == 0)
+    {
+        dispatchBench();
+        return 0;
+    }
+    if(argc > 1 && strcmp(argv[1], "tick") == 0)
+    {
+        tickBench();
+        return 0;
+    }
+
+    ok = createThread(idle, "Idle", 7, 512);
+    if(argc > 1 && strcmp(argv[1], "bench") == 0)
+    {
+        ok &= createThread(ping, "Ping", 4, 1024);
+        ok &= createThread(pong, "Pong", 4, 1024);
+    }
+    else if(argc > 1 && strcmp(argv[1], "notify") == 0)
+    {
+        ok &= createThread(notifyPing, "Ping", 4, 1024);
+        ok &= createThread(notifyPong, "Pong", 4, 1024);
+    }
+    else if(argc > 1 && strcmp(argv[1], "pi") == 0)
+    {
+        ok &= createThread(important, "Important", 0, 1024);
+        ok &= createThread(hog, "Hog", 4, 1024);
+        ok &= createThread(lengthyFn, "LengthyFn", 6, 1024);
+    }
+    else if(argc > 1 && strcmp(argv[1], "ring") == 0)
+    {
+        ok &= createThread(ringReader, "RingReader", 4, 1024);
+        ok &= createThread(ringWriter, "RingWriter", 5, 1024);
+    }
+    else if(argc > 1 && strcmp(argv[1], "timeout") == 0)
+    {
+        ok &= createThread(timeoutTest, "TimeoutTest", 4, 1024);
+        ok &= createThread(releaser, "Releaser", 3, 1024);
+    }
+    else if(argc > 1 && strcmp(argv[1], "queue") == 0)
+    {
+        ok &= createThread(producer, "Producer", 4, 1024);
+        ok &= createThread(consumer, "Consumer", 4, 1024);
+    }
+    else
+    {
+        ok &= createThread(shell, "Shell", 6, 4096);
+    }
+
+    if(ok)
+        startRtos();
+    return 1;
+}
+
+#endif
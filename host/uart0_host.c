@@ -0,0 +1,57 @@
+// UART0 on the terminal for the Linux host simulation
+// uart0.h functions over stdin/stdout, enter arrives as a carriage return like from a terminal emulator
+// end of input exits, so a session can be scripted from a file
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifdef HOST_SIM
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+#include <unistd.h>
+#include "../uart0.h"
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initUart0()
+{
+}
+
+void setUart0BaudRate(uint32_t baudRate, uint32_t fcyc)
+{
+}
+
+void putcUart0(char c)
+{
+    while(write(STDOUT_FILENO, &c, 1) != 1);
+}
+
+void putsUart0(char* str)
+{
+    uint32_t i;
+    for (i = 0; i < strlen(str); i++)
+        putcUart0(str[i]);
+}
+
+char getcUart0()
+{
+    char c = 0;
+    if(read(STDIN_FILENO, &c, 1) != 1)
+        exit(0);                            // end of a scripted session
+    return (c == '\n') ? '\r' : c;
+}
+
+bool kbhitUart0()
+{
+    struct pollfd p = {STDIN_FILENO, POLLIN, 0};
+    return poll(&p, 1, 0) > 0;
+}
+
+#endif
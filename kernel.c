@@ -13,13 +13,13 @@
 //-----------------------------------------------------------------------------
 
 #include <stdint.h>
-#include "tm4c123gh6pm.h"
+#include "port.h"
 #include "mm.h"
 #include "kernel.h"
 #include "uart0.h"
 #include "shell.h"
 #include "shell_func.h"
-#include "asm.h"
+#include "trace.h"
 
 extern int pid;
 extern uint8_t curr_tcb_i = 0;           // index of tcb for heap_map allocation ownership
@@ -31,9 +31,11 @@ extern uint8_t curr_tcb_i = 0;           // index of tcb for heap_map allocation
 typedef struct _mutex
 {
     bool lock;
-    uint8_t queueSize;
-    uint8_t processQueue[MAX_MUTEX_QUEUE_SIZE];
+    waitQueue queue;            // tasks blocked in lock()
     uint8_t lockedBy;
+    uint8_t ceiling;            // priority the owner is raised to on lock (NO_CEILING: inheritance when pi is on)
+    uint8_t nextHeld;           // next mutex held by the same owner (NO_MUTEX at the end)
+    bool valid;                 // initialized, shown by ipcs
 } mutex;
 mutex mutexes[MAX_MUTEXES];
 
@@ -41,11 +43,56 @@ mutex mutexes[MAX_MUTEXES];
 typedef struct _semaphore
 {
     uint8_t count;
-    uint8_t queueSize;
-    uint8_t processQueue[MAX_SEMAPHORE_QUEUE_SIZE];
+    waitQueue queue;            // tasks blocked in wait()
 } semaphore;
 semaphore semaphores[MAX_SEMAPHORES];
 
+// event group
+typedef struct _eventGroup
+{
+    uint32_t flags;
+    waitQueue queue;            // tasks blocked in waitEvents()
+    bool valid;                 // initialized, shown by ipcs
+} eventGroup;
+eventGroup eventGroups[MAX_EVENT_GROUPS];
+
+// reader-writer lock
+// any number of readers or one writer, both queues wake the highest priority waiter first
+typedef struct _rwLock
+{
+    uint8_t readers;            // tasks holding a read lock (their tcb[].readHeld bit is set)
+    uint8_t writer;             // task holding the write lock (NO_TASK if none)
+    waitQueue readQueue;        // tasks blocked in readLock()
+    waitQueue writeQueue;       // tasks blocked in writeLock()
+    bool writerPreference;      // a waiting writer holds back new readers, otherwise the higher priority goes first
+    bool valid;                 // initialized, shown by ipcs
+} rwLock;
+rwLock rwLocks[MAX_RWLOCKS];
+
+// condition variable
+typedef struct _condition
+{
+    waitQueue queue;            // tasks blocked in condWait()
+    bool valid;                 // initialized, shown by ipcs
+} condition;
+condition conditions[MAX_CONDITIONS];
+
+// message queue
+// ring of depth items of itemSize bytes, the storage comes from the heap
+typedef struct _msgQueue
+{
+    uint8_t *buffer;
+    uint8_t depth;
+    uint8_t itemSize;
+    uint8_t count;              // items in the ring
+    uint8_t head;               // index of the oldest item
+    waitQueue senders;          // tasks blocked in sendMessage() on a full queue
+    waitQueue receivers;        // tasks blocked in receiveMessage() on an empty queue
+    bool mailbox;               // items are heap buffers that change owner as they pass
+    bool valid;                 // initialized, shown by ipcs
+} msgQueue;
+msgQueue msgQueues[MAX_MSG_QUEUES];
+
 // task states
 #define STATE_INVALID           0 // no task
 #define STATE_UNRUN             1 // task has never been run
@@ -54,6 +101,14 @@ semaphore semaphores[MAX_SEMAPHORES];
 #define STATE_BLOCKED_SEMAPHORE 4 // has run, but now blocked by semaphore
 #define STATE_BLOCKED_MUTEX     5 // has run, but now blocked by mutex
 #define STATE_KILLED            6 // task has been killed
+#define STATE_THROTTLED         7 // has run, but used up its cpu budget until replenished
+#define STATE_BLOCKED_EVENT     8 // has run, but now waiting for flags of an event group
+#define STATE_BLOCKED_SEND      9 // has run, but now waiting for room in a message queue
+#define STATE_BLOCKED_RECEIVE  10 // has run, but now waiting for a message
+#define STATE_BLOCKED_NOTIFY   11 // has run, but now waiting for a task notification
+#define STATE_BLOCKED_CONDITION 12 // has run, but now waiting for a condition variable to be signalled
+#define STATE_BLOCKED_READ     13 // has run, but now waiting for a read lock
+#define STATE_BLOCKED_WRITE    14 // has run, but now waiting for a write lock
 
 #define YIELD   0
 #define SLEEP   1
@@ -73,6 +128,32 @@ semaphore semaphores[MAX_SEMAPHORES];
 #define RUN     15
 #define RESTART 16
 #define TPRIO   17
+#define TICKLESS 18
+#define TDEADLINE 19
+#define WAITPERIOD 20
+#define TQUANTUM 21
+#define PQUANTUM 22
+#define TBUDGET 23
+#define TRACE   24
+#define WAITTIMEOUT 25
+#define LOCKTIMEOUT 26
+#define SETEVENTS   27
+#define CLEAREVENTS 28
+#define WAITEVENTS  29
+#define SEND        30
+#define RECEIVE     31
+#define SENDWORD    32
+#define ALLOCMAIL   33
+#define FREEMAIL    34
+#define NOTIFY      35
+#define TAKENOTIFY  36
+#define CONDWAIT    37
+#define CONDSIGNAL  38
+#define CONDBROADCAST 39
+#define READLOCK    40
+#define WRITELOCK   41
+#define READUNLOCK  42
+#define WRITEUNLOCK 43
 
 // task
 uint8_t taskCurrent = 0;          // index of last dispatched task
@@ -80,12 +161,49 @@ uint8_t taskCount = 0;            // total number of valid tasks
 
 // control
 bool priorityScheduler = false;     // priority (true) or round-robin (false)
+bool edfScheduler = false;          // earliest deadline first for tasks with a deadline
 bool priorityInheritance = false;   // priority inheritance for mutexes
 bool preemption = false;            // preemption (true) or cooperative (false)
 bool pingpong = false;              //pingpong buffering
+bool ticklessMode = false;          // systick programmed for the next deadline (true) or every 1 ms (false)
+
+// system timer
+#define TICK_CYCLES         40000                       // 1 ms at 40 MHz
+#define MAX_TICKLESS_TICKS  (0x1000000 / TICK_CYCLES)   // longest period the 24-bit systick can count
+#define CPU_WINDOW          500                         // ticks between ps pingpong buffer swaps
+uint32_t tickPeriod = 1;            // ticks covered by the programmed systick period
+uint32_t tickOffset = 0;            // cycles between the last tick boundary and the start of the period
+uint32_t cpuWindowTime = 0;         // ticks into the current ps window
+uint32_t tickTime = 0;              // kernel time in ticks since startup (wraps after ~49 days)
 
 // tcb
 #define NUM_PRIORITIES   8
+#define NUM_LEVELS       (NUM_PRIORITIES + 1)   // edf adds a deadline level above the priorities
+#define EDF_LEVEL        0
+
+// ready queue
+// one intrusive FIFO per level linked through tcb[].readyNext/readyPrev
+// bit (31 - level) of readyBitmap is set while that level has a ready task,
+// so the highest ready level is found with a single CLZ
+// under edf the deadline level is kept sorted by absolute deadline instead
+uint32_t readyBitmap = 0;
+uint8_t readyHead[NUM_LEVELS];
+uint8_t readyTail[NUM_LEVELS];
+
+// context switch statistics
+uint8_t taskPrevious = 0;           // task running before the last dispatch
+uint32_t switchRequested = 0;       // pendsv requests
+uint32_t switchAvoided = 0;         // requests skipped because the running task was still the best candidate
+uint32_t switchUseful = 0;          // dispatches that changed the running task
+
+// time slices
+// a task runs until its quantum is used up before a peer on the same level gets the cpu
+uint32_t priorityQuantum[NUM_PRIORITIES];   // slice length in ticks for each priority
+
+// sleep delta queue
+// delayed tasks sorted by wakeup time, tcb[].ticks holds the delay after the previous entry
+// so the systick only ever looks at the head
+uint8_t sleepHead = NO_TASK;
 /*
 struct _tcb
 {
@@ -107,27 +225,223 @@ struct _tcb
 
 bool initMutex(uint8_t mutex)
 {
-    bool ok = (mutex < MAX_MUTEXES);
+    return initMutexCeiling(mutex, NO_CEILING);
+}
+
+// same as initMutex with the immediate priority ceiling protocol
+// the owner runs at ceiling (the highest priority of any task that locks the mutex)
+// from lock to unlock, so a task blocks on at most one critical section
+bool initMutexCeiling(uint8_t mutex, uint8_t ceiling)
+{
+    return initMutexOrder(mutex, ceiling, WAIT_FIFO);
+}
+
+// same as initMutexCeiling, order picks which waiter gets the mutex on unlock:
+// the longest waiting (WAIT_FIFO) or the highest priority (WAIT_PRIORITY)
+bool initMutexOrder(uint8_t mutex, uint8_t ceiling, uint8_t order)
+{
+    bool ok = (mutex < MAX_MUTEXES) && (ceiling == NO_CEILING || ceiling < NUM_PRIORITIES);
     if (ok)
     {
         mutexes[mutex].lock = false;
         mutexes[mutex].lockedBy = 0;
-        mutexes[mutex].queueSize = 0;
+        waitInit(&mutexes[mutex].queue, order);
+        mutexes[mutex].ceiling = ceiling;
+        mutexes[mutex].nextHeld = NO_MUTEX;
+        mutexes[mutex].valid = true;
     }
     return ok;
 }
 
+// priority task runs at: its own priority raised to the ceiling of every ceiling mutex it holds
+// and, with pi on, to the priority of every task waiting on a mutex it holds
+uint8_t mutexPriority(uint8_t task)
+{
+    uint8_t prio = tcb[task].priority;
+    uint8_t i, j;
+    for(i = tcb[task].mutexHeld; i != NO_MUTEX; i = mutexes[i].nextHeld)
+    {
+        if(mutexes[i].ceiling < prio)
+            prio = mutexes[i].ceiling;
+        if(priorityInheritance && mutexes[i].ceiling == NO_CEILING)
+        {
+            for(j = mutexes[i].queue.head; j != NO_TASK; j = tcb[j].waitNext)
+            {
+                if(tcb[j].currentPriority < prio)
+                    prio = tcb[j].currentPriority;
+            }
+        }
+    }
+    if(priorityInheritance)
+        prio = rwPriority(task, prio);
+    return prio;
+}
+
+// make task the owner of mutex and add it to the task's held list
+void mutexAcquire(uint8_t mutex, uint8_t task)
+{
+    mutexes[mutex].lock = true;
+    mutexes[mutex].lockedBy = task;
+    mutexes[mutex].nextHeld = tcb[task].mutexHeld;
+    tcb[task].mutexHeld = mutex;
+}
+
+// take mutex off its owner's held list and hand it to the first waiter (or unlock it)
+// the caller updates the old owner's priority
+void mutexRelease(uint8_t mutex)
+{
+    uint8_t owner = mutexes[mutex].lockedBy;
+    uint8_t *link = &tcb[owner].mutexHeld;
+    uint8_t next;
+    while(*link != NO_MUTEX && *link != mutex)
+        link = &mutexes[*link].nextHeld;
+    if(*link == mutex)
+        *link = mutexes[mutex].nextHeld;
+    mutexes[mutex].nextHeld = NO_MUTEX;
+    mutexes[mutex].lock = false;
+    mutexes[mutex].lockedBy = 0;
+    next = waitDequeue(&mutexes[mutex].queue);
+    if(next != NO_TASK)
+    {
+        if(tcb[next].condition == NO_CONDITION)
+            waitGranted(next, true);
+        else
+            tcb[next].condition = NO_CONDITION;     //relock after condWait, which returns what ended the wait
+        mutexAcquire(mutex, next);
+        tcb[next].mutex = NO_MUTEX;
+        tcb[next].state = STATE_READY;
+        priorityUpdate(next);                       //new owner inherits from the remaining waiters
+        readyInsert(next);
+        traceEvent(TRACE_WAKE, next, 0);
+    }
+}
+
+// bring the priority of task up to date after a lock, unlock or priority change
+// and follow the chain of owners: a blocked owner passes its new priority to the owner it waits on
+void priorityUpdate(uint8_t task)
+{
+    uint8_t hops = 0;
+    uint8_t prio;
+    while(task != NO_TASK && hops++ < MAX_TASKS)       //bounded in case of a deadlock cycle
+    {
+        prio = mutexPriority(task);
+        if(prio == tcb[task].currentPriority)
+            break;
+        tcb[task].currentPriority = prio;
+        readyRequeue(task);
+        waitRequeue(task);
+        if(tcb[task].state == STATE_BLOCKED_MUTEX)
+            task = mutexes[tcb[task].mutex].lockedBy;
+        else
+        {
+            if(tcb[task].state == STATE_BLOCKED_READ || tcb[task].state == STATE_BLOCKED_WRITE)
+                rwUpdateHolders(tcb[task].rwLock);      //a reader-writer lock can have several owners
+            task = NO_TASK;
+        }
+    }
+}
+
 bool initSemaphore(uint8_t semaphore, uint8_t count)
+{
+    return initSemaphoreOrder(semaphore, count, WAIT_FIFO);
+}
+
+// same as initSemaphore, order picks which waiter a post wakes (WAIT_FIFO or WAIT_PRIORITY)
+bool initSemaphoreOrder(uint8_t semaphore, uint8_t count, uint8_t order)
 {
     bool ok = (semaphore < MAX_SEMAPHORES);
     if(ok)
     {
         semaphores[semaphore].count = count;
-        semaphores[semaphore].queueSize = 0;
+        waitInit(&semaphores[semaphore].queue, order);
+    }
+    return ok;
+}
+
+// event group with all 32 flags clear
+bool initEventGroup(uint8_t group)
+{
+    bool ok = (group < MAX_EVENT_GROUPS);
+    if(ok)
+    {
+        eventGroups[group].flags = 0;
+        waitInit(&eventGroups[group].queue, WAIT_FIFO);
+        eventGroups[group].valid = true;
+    }
+    return ok;
+}
+
+// reader-writer lock, writerPreference holds back new readers while a writer waits
+// otherwise a new reader only passes a waiting writer of lower priority
+bool initRwLock(uint8_t rwLock, bool writerPreference)
+{
+    bool ok = (rwLock < MAX_RWLOCKS);
+    if(ok)
+    {
+        rwLocks[rwLock].readers = 0;
+        rwLocks[rwLock].writer = NO_TASK;
+        waitInit(&rwLocks[rwLock].readQueue, WAIT_PRIORITY);
+        waitInit(&rwLocks[rwLock].writeQueue, WAIT_PRIORITY);
+        rwLocks[rwLock].writerPreference = writerPreference;
+        rwLocks[rwLock].valid = true;
+    }
+    return ok;
+}
+
+bool initCondition(uint8_t condition)
+{
+    return initConditionOrder(condition, WAIT_FIFO);
+}
+
+// same as initCondition, order picks which waiter condSignal wakes:
+// the longest waiting (WAIT_FIFO) or the highest priority (WAIT_PRIORITY)
+bool initConditionOrder(uint8_t condition, uint8_t order)
+{
+    bool ok = (condition < MAX_CONDITIONS);
+    if(ok)
+    {
+        waitInit(&conditions[condition].queue, order);
+        conditions[condition].valid = true;
+    }
+    return ok;
+}
+
+// message queue of depth items of itemSize bytes, call before startRtos
+// the ring is allocated from the heap and owned by the kernel
+bool initMsgQueue(uint8_t queue, uint8_t depth, uint8_t itemSize)
+{
+    bool ok = (queue < MAX_MSG_QUEUES) && !msgQueues[queue].valid && (depth != 0) && (itemSize != 0);
+    if(ok)
+    {
+        msgQueues[queue].buffer = mallocHeap((uint32_t)depth * itemSize);
+        ok = (msgQueues[queue].buffer != NULL);
+    }
+    if(ok)
+    {
+        setHeapOwner(msgQueues[queue].buffer, NO_TASK, NULL);
+        msgQueues[queue].depth = depth;
+        msgQueues[queue].itemSize = itemSize;
+        msgQueues[queue].count = 0;
+        msgQueues[queue].head = 0;
+        msgQueues[queue].mailbox = false;
+        waitInit(&msgQueues[queue].senders, WAIT_FIFO);
+        waitInit(&msgQueues[queue].receivers, WAIT_FIFO);
+        msgQueues[queue].valid = true;
     }
     return ok;
 }
 
+// message queue of depth heap buffers, call before startRtos
+// a buffer sent through it leaves the sender's MPU window and heap ownership
+// and is given to the task that receives it, so the payload is never copied or shared
+bool initMailbox(uint8_t queue, uint8_t depth)
+{
+    bool ok = initMsgQueue(queue, depth, MAIL_SIZE);
+    if(ok)
+        msgQueues[queue].mailbox = true;
+    return ok;
+}
+
 // REQUIRED: initialize systick for 1ms system timer
 void initRtos(void)
 {
@@ -141,63 +455,379 @@ void initRtos(void)
         tcb[i].pid = 0;
         tcb[i].timeA = 0;
         tcb[i].timeB = 0;
+        tcb[i].readyNext = NO_TASK;
+        tcb[i].readyPrev = NO_TASK;
+        tcb[i].readyLevel = NO_LEVEL;
+        tcb[i].sleepNext = NO_TASK;
+        tcb[i].sleepPrev = NO_TASK;
+        tcb[i].waitNext = NO_TASK;
+        tcb[i].waitPrev = NO_TASK;
+        tcb[i].mutex = NO_MUTEX;
+        tcb[i].mutexHeld = NO_MUTEX;
+    }
+    sleepHead = NO_TASK;
+    // empty ready queues
+    readyBitmap = 0;
+    for (i = 0; i < NUM_LEVELS; i++)
+    {
+        readyHead[i] = NO_TASK;
+        readyTail[i] = NO_TASK;
+    }
+    for (i = 0; i < NUM_PRIORITIES; i++)
+    {
+        priorityQuantum[i] = 1;
     }
+    portPrioritiesInit();
     initWTimer();
+    initTrace();
 
 }
 
 void initWTimer(void)
 {
-    SYSCTL_RCGCWTIMER_R |= SYSCTL_RCGCWTIMER_R0;        //WTimer 0 clock
-    _delay_cycles(3);
-    WTIMER0_CTL_R &= ~TIMER_CTL_TAEN;   //timer off for configuration
-    WTIMER0_CFG_R = TIMER_CFG_32_BIT_TIMER;
-    WTIMER0_TAMR_R = TIMER_TAMR_TAMR_1_SHOT | TIMER_TAMR_TACDIR;
-    WTIMER0_TAILR_R = 40000000;
-    WTIMER0_TAV_R = 0;
-    WTIMER0_CTL_R |= TIMER_CTL_TAEN;
+    tickPeriod = 1;
+    tickOffset = 0;
+    portTimersInit(TICK_CYCLES - 1);
+}
 
-    NVIC_ST_CTRL_R = 0;             //turn off for configuration
-    NVIC_ST_RELOAD_R |= 40000;
-    NVIC_ST_CURRENT_R = 0;
-    NVIC_ST_CTRL_R |= NVIC_ST_CTRL_CLK_SRC | NVIC_ST_CTRL_INTEN | NVIC_ST_CTRL_ENABLE;  //use sys clock and enable interrupt
+// level a ready task is queued on
+// priority scheduling uses the current priority, round-robin puts every task on level 0
+// edf puts tasks with a deadline on the deadline level and the rest below it by priority
+uint8_t readyLevelOf(uint8_t task)
+{
+    if(edfScheduler)
+    {
+        if(tcb[task].deadline != 0)
+            return EDF_LEVEL;
+        return tcb[task].currentPriority + 1;
+    }
+    if(priorityScheduler)
+        return tcb[task].currentPriority;
+    return 0;
 }
 
-// REQUIRED: Implement prioritization to NUM_PRIORITIES
-uint8_t rtosScheduler(void)
+// true if the level is ordered by absolute deadline rather than fifo
+bool readyLevelSorted(uint8_t level)
+{
+    return edfScheduler && level == EDF_LEVEL;
+}
+
+// slice length of task: its own quantum if set, otherwise the one of its priority
+uint32_t quantumOf(uint8_t task)
+{
+    if(tcb[task].quantum != 0)
+        return tcb[task].quantum;
+    return priorityQuantum[tcb[task].currentPriority];
+}
+
+// append task to the tail of its ready queue with a fresh time slice (no-op if already queued)
+// on the edf level it goes after every task with an earlier or equal deadline
+void readyInsert(uint8_t task)
+{
+    if(tcb[task].readyLevel != NO_LEVEL)
+        return;
+    tcb[task].sliceLeft = quantumOf(task);
+    uint8_t level = readyLevelOf(task);
+    uint8_t prev = readyTail[level];
+    if(readyLevelSorted(level))
+    {
+        while(prev != NO_TASK && (int32_t)(tcb[task].absDeadline - tcb[prev].absDeadline) < 0)
+            prev = tcb[prev].readyPrev;
+    }
+    uint8_t next = (prev == NO_TASK) ? readyHead[level] : tcb[prev].readyNext;
+    tcb[task].readyLevel = level;
+    tcb[task].readyNext = next;
+    tcb[task].readyPrev = prev;
+    if(prev == NO_TASK)
+        readyHead[level] = task;
+    else
+        tcb[prev].readyNext = task;
+    if(next == NO_TASK)
+        readyTail[level] = task;
+    else
+        tcb[next].readyPrev = task;
+    readyBitmap |= (0x80000000 >> level);
+}
+
+// a new job of task becomes ready: its absolute deadline restarts from now
+void readyRelease(uint8_t task)
+{
+    traceEvent(TRACE_WAKE, task, 0);
+    tcb[task].absDeadline = tickTime + tcb[task].deadline;
+    readyInsert(task);
+}
+
+// unlink task from its ready queue (no-op if not queued)
+void readyRemove(uint8_t task)
+{
+    uint8_t level = tcb[task].readyLevel;
+    if(level == NO_LEVEL)
+        return;
+    uint8_t next = tcb[task].readyNext;
+    uint8_t prev = tcb[task].readyPrev;
+    if(prev == NO_TASK)
+        readyHead[level] = next;
+    else
+        tcb[prev].readyNext = next;
+    if(next == NO_TASK)
+        readyTail[level] = prev;
+    else
+        tcb[next].readyPrev = prev;
+    if(readyHead[level] == NO_TASK)
+        readyBitmap &= ~(0x80000000 >> level);
+    tcb[task].readyNext = NO_TASK;
+    tcb[task].readyPrev = NO_TASK;
+    tcb[task].readyLevel = NO_LEVEL;
+}
+
+// move a queued task after its current priority changed
+void readyRequeue(uint8_t task)
+{
+    if(tcb[task].readyLevel != NO_LEVEL && tcb[task].readyLevel != readyLevelOf(task))
+    {
+        readyRemove(task);
+        readyInsert(task);
+    }
+}
+
+// rebuild every ready queue after the scheduling mode changed
+void readyRebuild(void)
+{
+    uint8_t i;
+    for(i = 0; i < MAX_TASKS; i++)
+    {
+        readyRemove(i);
+    }
+    for(i = 0; i < MAX_TASKS; i++)
+    {
+        if(tcb[i].state == STATE_READY || tcb[i].state == STATE_UNRUN)
+            readyInsert(i);
+    }
+}
+
+// insert task into the sleep delta queue to wake ticks from now
+void sleepInsert(uint8_t task, uint32_t ticks)
+{
+    uint8_t prev = NO_TASK;
+    uint8_t next = sleepHead;
+    while(next != NO_TASK && tcb[next].ticks <= ticks)  //equal deadlines stay fifo
+    {
+        ticks -= tcb[next].ticks;
+        prev = next;
+        next = tcb[next].sleepNext;
+    }
+    tcb[task].ticks = ticks;
+    tcb[task].sleepPrev = prev;
+    tcb[task].sleepNext = next;
+    if(prev == NO_TASK)
+        sleepHead = task;
+    else
+        tcb[prev].sleepNext = task;
+    if(next != NO_TASK)
+    {
+        tcb[next].ticks -= ticks;
+        tcb[next].sleepPrev = task;
+    }
+}
+
+// unlink task from the sleep delta queue, its delay is handed to the next sleeper
+void sleepRemove(uint8_t task)
+{
+    uint8_t next = tcb[task].sleepNext;
+    uint8_t prev = tcb[task].sleepPrev;
+    if(prev == NO_TASK && sleepHead != task)
+        return;                                     //not sleeping
+    if(prev == NO_TASK)
+        sleepHead = next;
+    else
+        tcb[prev].sleepNext = next;
+    if(next != NO_TASK)
+    {
+        tcb[next].ticks += tcb[task].ticks;
+        tcb[next].sleepPrev = prev;
+    }
+    tcb[task].sleepNext = NO_TASK;
+    tcb[task].sleepPrev = NO_TASK;
+    tcb[task].ticks = 0;
+}
+
+// ticks until a sleeping task wakes (sum of the deltas up to it)
+uint32_t sleepRemaining(uint8_t task)
+{
+    uint32_t ticks = 0;
+    uint8_t i = sleepHead;
+    while(i != NO_TASK)
+    {
+        ticks += tcb[i].ticks;
+        if(i == task)
+            return ticks;
+        i = tcb[i].sleepNext;
+    }
+    return 0;
+}
+
+// empty wait queue woken in fifo (WAIT_FIFO) or priority (WAIT_PRIORITY) order
+void waitInit(waitQueue *queue, uint8_t order)
+{
+    queue->head = NO_TASK;
+    queue->tail = NO_TASK;
+    queue->size = 0;
+    queue->order = order;
+}
+
+// append task to the tail of queue
+// a priority ordered queue puts it after every task of higher or equal current priority
+void waitEnqueue(waitQueue *queue, uint8_t task)
+{
+    uint8_t prev = queue->tail;
+    if(queue->order == WAIT_PRIORITY)
+    {
+        while(prev != NO_TASK && tcb[prev].currentPriority > tcb[task].currentPriority)
+            prev = tcb[prev].waitPrev;
+    }
+    uint8_t next = (prev == NO_TASK) ? queue->head : tcb[prev].waitNext;
+    tcb[task].waitNext = next;
+    tcb[task].waitPrev = prev;
+    if(prev == NO_TASK)
+        queue->head = task;
+    else
+        tcb[prev].waitNext = task;
+    if(next == NO_TASK)
+        queue->tail = task;
+    else
+        tcb[next].waitPrev = task;
+    queue->size++;
+}
+
+// unlink and return the first task of queue (NO_TASK if empty)
+uint8_t waitDequeue(waitQueue *queue)
 {
-    if(priorityScheduler)       //priority
+    uint8_t task = queue->head;
+    if(task != NO_TASK)
+        waitRemove(queue, task);
+    return task;
+}
+
+// unlink task from queue wherever it is
+void waitRemove(waitQueue *queue, uint8_t task)
+{
+    uint8_t next = tcb[task].waitNext;
+    uint8_t prev = tcb[task].waitPrev;
+    if(prev == NO_TASK && queue->head != task)
+        return;                                     //not queued
+    if(prev == NO_TASK)
+        queue->head = next;
+    else
+        tcb[prev].waitNext = next;
+    if(next == NO_TASK)
+        queue->tail = prev;
+    else
+        tcb[next].waitPrev = prev;
+    tcb[task].waitNext = NO_TASK;
+    tcb[task].waitPrev = NO_TASK;
+    queue->size--;
+}
+
+// wait queue of the object task is blocked on (NULL if not blocked on one)
+waitQueue *waitQueueOf(uint8_t task)
+{
+    if(tcb[task].state == STATE_BLOCKED_MUTEX && tcb[task].mutex < MAX_MUTEXES)
+        return &mutexes[tcb[task].mutex].queue;
+    if(tcb[task].state == STATE_BLOCKED_SEMAPHORE && tcb[task].semaphore < MAX_SEMAPHORES)
+        return &semaphores[tcb[task].semaphore].queue;
+    if(tcb[task].state == STATE_BLOCKED_READ && tcb[task].rwLock < MAX_RWLOCKS)
+        return &rwLocks[tcb[task].rwLock].readQueue;
+    if(tcb[task].state == STATE_BLOCKED_WRITE && tcb[task].rwLock < MAX_RWLOCKS)
+        return &rwLocks[tcb[task].rwLock].writeQueue;
+    if(tcb[task].state == STATE_BLOCKED_CONDITION && tcb[task].condition < MAX_CONDITIONS)
+        return &conditions[tcb[task].condition].queue;
+    if(tcb[task].state == STATE_BLOCKED_EVENT && tcb[task].event < MAX_EVENT_GROUPS)
+        return &eventGroups[tcb[task].event].queue;
+    if(tcb[task].state == STATE_BLOCKED_SEND && tcb[task].msgQueue < MAX_MSG_QUEUES)
+        return &msgQueues[tcb[task].msgQueue].senders;
+    if(tcb[task].state == STATE_BLOCKED_RECEIVE && tcb[task].msgQueue < MAX_MSG_QUEUES)
+        return &msgQueues[tcb[task].msgQueue].receivers;
+    return NULL;
+}
+
+// a waiter got the object it blocked on: cancel its timeout and make its call return result
+void waitGranted(uint8_t task, uint32_t result)
+{
+    sleepRemove(task);
+    if(task == taskCurrent)                         //woken by a handler before pendsv switched it out
+        PORT_SET_RESULT_CURRENT(result);
+    else
+        PORT_SET_RESULT(tcb[task].sp, result);
+}
+
+// the timeout of a waiter ran out: take it off the queue of the object it waited on
+// its call returns the false stacked when it blocked
+// returns true if the task can run, false if a condition waiter now waits to relock its mutex
+bool waitExpire(uint8_t task)
+{
+    waitQueue *queue = waitQueueOf(task);
+    if(queue != NULL)
     {
-        static uint8_t taskArr[NUM_PRIORITIES] = {0};
-        uint8_t prio = 0;
-        for(prio = 0; prio < NUM_PRIORITIES; prio++)    //go through all 8 prio levels
+        waitRemove(queue, task);
+        if(tcb[task].state == STATE_BLOCKED_MUTEX)
         {
-            uint8_t task = taskArr[prio];
-            uint8_t i;
-            for(i = 0; i < MAX_TASKS; i++)              //check all tasks at that level
-            {
-                bool task_state = (tcb[task].state == STATE_READY || tcb[task].state == STATE_UNRUN);
-                if(task_state && tcb[task].currentPriority == prio)
-                {
-                    taskArr[prio] = (task + 1) % taskCount;
-                    return task;
-                }
-                task = (task + 1) % taskCount;
-            }
+            priorityUpdate(mutexes[tcb[task].mutex].lockedBy);    //owner no longer inherits from it
+            tcb[task].mutex = NO_MUTEX;
         }
+        else if(tcb[task].state == STATE_BLOCKED_CONDITION)
+        {
+            return condRelock(task);
+        }
+    }
+    return true;
+}
+
+// move a waiting task after its current priority changed
+void waitRequeue(uint8_t task)
+{
+    waitQueue *queue = waitQueueOf(task);
+    if(queue != NULL && queue->order == WAIT_PRIORITY)
+    {
+        waitRemove(queue, task);
+        waitEnqueue(queue, task);
     }
+}
 
-    bool ok;
-    static uint8_t task = 0xFF;
-    ok = false;
-    while (!ok)
+// send task behind its peers on the same level (yield or used up time slice)
+// the edf level is not rotated, its head is always the earliest deadline
+void readyRotate(uint8_t task)
+{
+    if(tcb[task].readyLevel != NO_LEVEL && !readyLevelSorted(tcb[task].readyLevel))
     {
-        task++;
-        if (task >= MAX_TASKS)
-            task = 0;
-        ok = (tcb[task].state == STATE_READY || tcb[task].state == STATE_UNRUN);
+        readyRemove(task);
+        readyInsert(task);
+    }
+}
+
+// REQUIRED: Implement prioritization to NUM_PRIORITIES
+// O(1): highest ready level from the bitmap, head of that level is dispatched
+// tasks on the same level take turns as they yield or their time slice runs out
+// with nothing ready (getClz(0) = 32 is no level) the running task is kept
+uint8_t rtosScheduler(void)
+{
+    uint8_t level = getClz(readyBitmap);
+    if(level >= NUM_LEVELS)
+        return taskCurrent;
+    return readyHead[level];
+}
+
+// request a task switch only if the ready set holds a better candidate than the running task
+void reschedule(void)
+{
+    if(rtosScheduler() != taskCurrent)
+    {
+        switchRequested++;
+        PORT_PEND_SWITCH();
+    }
+    else
+    {
+        switchAvoided++;
     }
-    return task;
 }
 
 // REQUIRED: modify this function to start the operating system
@@ -210,11 +840,9 @@ void startRtos(void)
 {
     taskCurrent = rtosScheduler();
     applySramAccessMask(tcb[taskCurrent].srd);
-    setPSP(tcb[taskCurrent].sp);
-    setASP();
+    tcb[taskCurrent].state = STATE_READY;           //already running, pendsv must not build a fresh frame for it
     _fn fn = (_fn)tcb[taskCurrent].pid;
-    setTMPL(1);
-    fn();
+    PORT_START(tcb[taskCurrent].sp, fn);
 }
 
 // REQUIRED:
@@ -223,11 +851,29 @@ void startRtos(void)
 // allocate stack space and store top of stack in sp
 // set the srd bits based on the memory allocation
 bool createThread(_fn fn, const char name[], uint8_t priority, uint32_t stackBytes)     //not allow re-entrancy         run before startRTOS in priv
+{
+    return createThreadTimed(fn, name, priority, stackBytes, 0, 0);
+}
+
+// same as createThread with a relative deadline in ticks used by edf (0 = no deadline)
+bool createThreadDeadline(_fn fn, const char name[], uint8_t priority, uint32_t stackBytes, uint32_t deadline)
+{
+    return createThreadTimed(fn, name, priority, stackBytes, 0, deadline);
+}
+
+// same as createThread for a task released every period ticks through waitNextPeriod()
+// the deadline is implicit (equal to the period)
+bool createThreadPeriodic(_fn fn, const char name[], uint8_t priority, uint32_t stackBytes, uint32_t period)
+{
+    return createThreadTimed(fn, name, priority, stackBytes, period, period);
+}
+
+bool createThreadTimed(_fn fn, const char name[], uint8_t priority, uint32_t stackBytes, uint32_t period, uint32_t deadline)
 {
     bool ok = false;
     uint8_t i = 0;
     bool found = false;
-    if (taskCount < MAX_TASKS)
+    if (taskCount < MAX_TASKS && priority < NUM_PRIORITIES)     //the priority indexes the ready queues
     {
         // make sure fn not already in list (prevent reentrancy)
         while (!found && (i < MAX_TASKS))       //not found and i is less than 12
@@ -262,6 +908,16 @@ bool createThread(_fn fn, const char name[], uint8_t priority, uint32_t stackByt
                 tcb[i].name[j] = name[j];
             }
             tcb[i].name[j] = '\0';
+            tcb[i].deadline = deadline;
+            tcb[i].period = period;
+            tcb[i].nextRelease = tickTime;
+            tcb[i].overruns = 0;
+            tcb[i].quantum = 0;
+            tcb[i].budget = 0;
+            tcb[i].notifyValue = 0;
+            tcb[i].condition = NO_CONDITION;
+            tcb[i].readHeld = 0;
+            readyRelease(i);
 
             // increment task count
             taskCount++;
@@ -281,329 +937,1269 @@ _fn getPid(void)
 //           unlock any mutexes, mark state as killed
 void killThread(_fn pid)
 {
-    __asm(" SVC #14");
+    PORT_SVC1(14, pid);
+}
+
+void killT(_fn pid)
+{
+    uint8_t i = 0,j = 0;
+    for(i = 0; i < 12; i++)
+    {
+        if(tcb[i].pid == pid && tcb[i].state != STATE_KILLED)
+        {
+            freeHeapPid(tcb[i].pid);                   //memory freed
+            tcb[i].srd = createNoSramAccessMask();              //clear srd, base add, and sp
+            tcb[i].sp = NULL;
+            readyRemove(i);
+            sleepRemove(i);
+            while(tcb[i].mutexHeld != NO_MUTEX)                 //owned mutexes go to their next waiter
+            {
+                mutexRelease(tcb[i].mutexHeld);
+            }
+            for(j = 0; j < MAX_RWLOCKS; j++)                    //and held reader-writer locks to theirs
+            {
+                if(rwLocks[j].valid && (rwLocks[j].writer == i || (tcb[i].readHeld & (1 << j))))
+                    rwRelease(j, i);
+            }
+            if(tcb[i].state == STATE_BLOCKED_MUTEX && tcb[i].mutex < MAX_MUTEXES)   //removes from queue if blocked
+            {
+                uint8_t m = tcb[i].mutex;
+                waitRemove(&mutexes[m].queue, i);
+                priorityUpdate(mutexes[m].lockedBy);        //owner no longer inherits from it
+                tcb[i].mutex = NO_MUTEX;
+            }
+            else if(tcb[i].state == STATE_BLOCKED_READ || tcb[i].state == STATE_BLOCKED_WRITE)
+            {
+                j = tcb[i].rwLock;
+                waitRemove(waitQueueOf(i), i);
+                rwUpdateHolders(j);                             //holders no longer inherit from it
+                rwAdmit(j);                                     //readers held back by a waiting writer
+            }
+            else if(waitQueueOf(i) != NULL)                        //semaphore, event group
+            {
+                waitRemove(waitQueueOf(i), i);
+            }
+            tcb[i].state = STATE_KILLED;
+            reschedule();                           //curr task killed or a waiter got one of its mutexes
+        }
+    }
+}
+
+// REQUIRED: modify this function to restart a thread, including creating a stack
+void restartThread(_fn fn)
+{
+    PORT_SVC1(16, fn);
+}
+
+// REQUIRED: modify this function to set a thread priority
+void setThreadPriority(_fn fn, uint8_t priority)
+{
+    PORT_SVC2(17, fn, priority);
+}
+
+// set the relative deadline in ticks used by edf (0 = no deadline)
+void setThreadDeadline(_fn fn, uint32_t deadline)
+{
+    PORT_SVC2(19, fn, deadline);
+}
+
+// REQUIRED: modify this function to yield execution back to scheduler using pendsv
+void yield(void)
+{
+    PORT_SVC0(0);
+}
+
+// REQUIRED: modify this function to support 1ms system timer
+// execution yielded back to scheduler until time elapses using pendsv
+void sleep(uint32_t tick)
+{
+    PORT_SVC1(1, tick);
+}
+
+// set the time slice of a thread in ticks (0 = use the slice of its priority)
+void setThreadQuantum(_fn fn, uint32_t ticks)
+{
+    PORT_SVC2(21, fn, ticks);
+}
+
+// set the time slice in ticks for every thread of a priority without its own quantum
+void setPriorityQuantum(uint8_t priority, uint32_t ticks)
+{
+    PORT_SVC2(22, priority, ticks);
+}
+
+// limit a thread to us microseconds of cpu time every period ticks (us = 0 removes the budget)
+// a thread that uses up its budget is throttled until the next replenishment
+void setThreadBudget(_fn fn, uint32_t us, uint32_t period)
+{
+    PORT_SVC3(23, fn, us, period);
+}
+
+// sleep until the next absolute release time of a periodic task
+// releases are kept by the kernel so the period does not drift with the task's run time
+void waitNextPeriod(void)
+{
+    PORT_SVC0(20);
+}
+
+// REQUIRED: modify this function to wait a semaphore using pendsv
+void wait(int8_t semaphore)
+{
+    PORT_SVC1(4, semaphore);
+}
+
+// same as wait, giving up after ticks (0 = do not block)
+// returns true if the semaphore was taken, false on timeout
+bool waitTimeout(int8_t semaphore, uint32_t ticks)
+{
+    PORT_SVC_RET2(25, bool, semaphore, ticks);
+}
+
+// REQUIRED: modify this function to signal a semaphore is available using pendsv
+void post(int8_t semaphore)
+{
+    PORT_SVC1(5, semaphore);
+}
+
+// REQUIRED: modify this function to lock a mutex using pendsv
+void lock(int8_t mutex)
+{
+    PORT_SVC1(2, mutex);
+}
+
+// same as lock, giving up after ticks (0 = do not block)
+// returns true if the mutex was locked, false on timeout
+bool lockTimeout(int8_t mutex, uint32_t ticks)
+{
+    PORT_SVC_RET2(26, bool, mutex, ticks);
+}
+
+// REQUIRED: modify this function to unlock a mutex using pendsv
+void unlock(int8_t mutex)
+{
+    PORT_SVC1(3, mutex);
+}
+
+// set flags of an event group, every waiter whose condition now holds is woken
+void setEvents(uint8_t group, uint32_t flags)
+{
+    PORT_SVC2(27, group, flags);
+}
+
+void clearEvents(uint8_t group, uint32_t flags)
+{
+    PORT_SVC2(28, group, flags);
+}
+
+// wait until any (EVENT_ANY) or all (EVENT_ALL) of flags are set in group, for at most ticks
+// (0 = do not block, WAIT_FOREVER = no timeout), EVENT_CLEAR clears the flags waited for once they are
+// returns the flags of the group that ended the wait, 0 on timeout
+uint32_t waitEvents(uint8_t group, uint32_t flags, uint8_t mode, uint32_t ticks)
+{
+    PORT_SVC_RET4(29, uint32_t, group, flags, mode, ticks);
+}
+
+// post, setEvents, clearEvents, sendMessage and notify for interrupt handlers, which cannot make service calls
+// they run under the kernel critical section, so the handler must not be above PORT_KERNEL_PRIORITY
+// a woken task only pends pendsv if it should preempt the interrupted one (see reschedule)
+void postFromIsr(int8_t semaphore)
+{
+    uint32_t mask;
+    if(semaphore >= 0 && semaphore < MAX_SEMAPHORES)
+    {
+        mask = PORT_ENTER_CRITICAL();
+        ticklessSync();
+        semaphorePost(semaphore);
+        ticklessProgram();
+        PORT_EXIT_CRITICAL(mask);
+    }
+}
+
+void setEventsFromIsr(uint8_t group, uint32_t flags)
+{
+    uint32_t mask;
+    if(group < MAX_EVENT_GROUPS && eventGroups[group].valid)
+    {
+        mask = PORT_ENTER_CRITICAL();
+        ticklessSync();
+        eventSet(group, flags);
+        ticklessProgram();
+        PORT_EXIT_CRITICAL(mask);
+    }
+}
+
+// clearing wakes nobody, so the tick is left alone
+void clearEventsFromIsr(uint8_t group, uint32_t flags)
+{
+    uint32_t mask;
+    if(group < MAX_EVENT_GROUPS && eventGroups[group].valid)
+    {
+        mask = PORT_ENTER_CRITICAL();
+        eventGroups[group].flags &= ~flags;
+        PORT_EXIT_CRITICAL(mask);
+    }
+}
+
+// never blocks, returns false if queue is full
+// mailboxes are refused, a handler cannot own the buffer it would pass
+bool sendMessageFromIsr(uint8_t queue, const void *item)
+{
+    uint32_t mask;
+    bool ok = false;
+    if(queue < MAX_MSG_QUEUES && msgQueues[queue].valid && !msgQueues[queue].mailbox)
+    {
+        mask = PORT_ENTER_CRITICAL();
+        ticklessSync();
+        ok = msgSend(queue, item);
+        ticklessProgram();
+        PORT_EXIT_CRITICAL(mask);
+    }
+    return ok;
+}
+
+void notifyFromIsr(_fn fn, uint32_t value, uint8_t action)
+{
+    uint32_t mask;
+    mask = PORT_ENTER_CRITICAL();
+    ticklessSync();
+    notifyPid((void*)fn, value, action);
+    ticklessProgram();
+    PORT_EXIT_CRITICAL(mask);
+}
+
+// copy item into queue, blocking up to ticks while it is full (0 = do not block)
+// returns true if the item was queued, false on timeout
+bool sendMessage(uint8_t queue, const void *item, uint32_t ticks)
+{
+    PORT_SVC_RET3(30, bool, queue, item, ticks);
+}
+
+// copy the oldest item of queue into item, blocking up to ticks while it is empty
+// returns true if an item was received, false on timeout
+bool receiveMessage(uint8_t queue, void *item, uint32_t ticks)
+{
+    PORT_SVC_RET3(31, bool, queue, item, ticks);
+}
+
+bool trySendMessage(uint8_t queue, const void *item)
+{
+    return sendMessage(queue, item, 0);
+}
+
+bool tryReceiveMessage(uint8_t queue, void *item)
+{
+    return receiveMessage(queue, item, 0);
+}
+
+// sendMessage for queues of 4 byte items, the word is passed in a register instead of through memory
+// returns false at once on a queue of any other item size
+bool sendWord(uint8_t queue, uint32_t word, uint32_t ticks)
+{
+    PORT_SVC_RET3(32, bool, queue, word, ticks);
+}
+
+// heap buffer of size bytes for mailboxes, owned by and open to the calling task (NULL if none is free)
+void * allocMail(uint32_t size)
+{
+    PORT_SVC_RET1(33, void*, size);
+}
+
+// free a buffer from allocMail or receiveMail owned by the calling task
+void freeMail(void *buffer)
+{
+    PORT_SVC1(34, buffer);
+}
+
+// send a buffer owned by the calling task through a mailbox, blocking up to ticks while it is full
+// returns false on timeout or if the caller does not own buffer, it keeps the buffer in that case
+bool sendMail(uint8_t queue, void *buffer, uint32_t ticks)
+{
+    return sendWord(queue, (uint32_t)(uintptr_t)buffer, ticks);
+}
+
+// receive a buffer from a mailbox, blocking up to ticks while it is empty
+// the caller owns the buffer afterwards, returns false on timeout
+bool receiveMail(uint8_t queue, void **buffer, uint32_t ticks)
+{
+    uint32_t address = 0;
+    bool ok = receiveMessage(queue, &address, ticks);
+    *buffer = (void*)(uintptr_t)address;
+    return ok;
+}
+
+// shared lock for readers, blocks while a writer holds the lock or (see initRwLock) waits for it
+void readLock(uint8_t rwLock)
+{
+    PORT_SVC1(40, rwLock);
+}
+
+void readUnlock(uint8_t rwLock)
+{
+    PORT_SVC1(42, rwLock);
+}
+
+// exclusive lock for a writer, blocks while any reader or another writer holds the lock
+void writeLock(uint8_t rwLock)
+{
+    PORT_SVC1(41, rwLock);
+}
+
+void writeUnlock(uint8_t rwLock)
+{
+    PORT_SVC1(43, rwLock);
+}
+
+// unlock mutex (held by the caller) and wait on condition in one step, for at most ticks
+// (WAIT_FOREVER = no timeout), the mutex is locked again before it returns
+// returns true if signalled, false on timeout or if the caller does not own mutex (then nothing is done)
+bool condWait(uint8_t condition, int8_t mutex, uint32_t ticks)
+{
+    PORT_SVC_RET3(37, bool, condition, mutex, ticks);
+}
+
+// wake the first waiter of condition
+void condSignal(uint8_t condition)
+{
+    PORT_SVC1(38, condition);
+}
+
+// wake every waiter of condition
+void condBroadcast(uint8_t condition)
+{
+    PORT_SVC1(39, condition);
+}
+
+// signal task fn through its notification word, no kernel object is needed (see NOTIFY_ actions)
+// fn wakes if it is blocked in takeNotify and the word is now nonzero
+void notify(_fn fn, uint32_t value, uint8_t action)
+{
+    PORT_SVC3(35, fn, value, action);
+}
+
+// wait up to ticks for the calling task's notification word to become nonzero
+// (0 = do not block, WAIT_FOREVER = no timeout), then clear it (clear) or decrement it
+// returns the word before it was cleared or decremented, 0 on timeout
+uint32_t takeNotify(bool clear, uint32_t ticks)
+{
+    PORT_SVC_RET2(36, uint32_t, clear, ticks);
+}
+
+// cpu budgets
+// run time is measured in WTIMER0 cycles (40 per us), the budget is refilled every budgetPeriod ticks
+#define CYCLES_PER_US   40
+
+// refill the budget of task if its replenishment time has passed
+void budgetReplenish(uint8_t task)
+{
+    if((int32_t)(tickTime - tcb[task].budgetNext) >= 0)
+    {
+        tcb[task].budgetNext += ((tickTime - tcb[task].budgetNext) / tcb[task].budgetPeriod + 1) * tcb[task].budgetPeriod;
+        tcb[task].budgetUsed = 0;
+    }
+}
+
+// true if task is the only ready task, nothing could run in its place
+bool readyOnly(uint8_t task)
+{
+    uint8_t level = tcb[task].readyLevel;
+    return level != NO_LEVEL && readyBitmap == (0x80000000 >> level)
+        && readyHead[level] == task && tcb[task].readyNext == NO_TASK;
+}
+
+// throttle the running task until its replenishment if it used up its budget
+// the last ready task (idle with a budget) keeps running over its budget
+// the run time is charged to budgetUsed first (see runCharge)
+bool budgetCheck(void)
+{
+    uint8_t task = taskCurrent;
+    if(tcb[task].budget != 0 && tcb[task].readyLevel != NO_LEVEL)
+    {
+        budgetReplenish(task);
+        if(tcb[task].budgetUsed >= tcb[task].budget && !readyOnly(task))
+        {
+            tcb[task].state = STATE_THROTTLED;
+            readyRemove(task);
+            traceEvent(TRACE_BLOCK, task, STATE_THROTTLED);
+            sleepInsert(task, tcb[task].budgetNext - tickTime);     //woken at the replenishment
+            return true;
+        }
+    }
+    return false;
+}
+
+// charge the cycles the running task used since the run timer was restarted to ps and its budget
+// done at every switch, and by the tick often enough that the one-shot run timer (1 s) never runs out
+void runCharge(void)
+{
+    uint32_t time = PORT_RUN_TIME();
+    if(pingpong)
+        tcb[taskCurrent].timeA += time;
+    else
+        tcb[taskCurrent].timeB += time;
+    if(tcb[taskCurrent].budget != 0)
+        tcb[taskCurrent].budgetUsed += time;
+    PORT_RUN_RESTART();
+}
+
+// charge elapsed ticks to the running task's slice, it goes behind its peers when the slice runs out
+void sliceAdvance(uint32_t elapsed)
+{
+    if(preemption && tcb[taskCurrent].readyLevel != NO_LEVEL)
+    {
+        if(tcb[taskCurrent].sliceLeft > elapsed)
+        {
+            tcb[taskCurrent].sliceLeft -= elapsed;
+        }
+        else
+        {
+            readyRotate(taskCurrent);
+            tcb[taskCurrent].sliceLeft = quantumOf(taskCurrent);
+        }
+    }
+}
+
+// advance kernel time by elapsed ticks: charge the time slice, wake sleepers, swap ps buffers
+void tickAdvance(uint32_t elapsed)
+{
+    uint8_t i = 0;
+    uint32_t ticks = elapsed;
+    sliceAdvance(elapsed);
+    while(sleepHead != NO_TASK && tcb[sleepHead].ticks <= ticks)   //wake every expired sleeper in one batch
+    {
+        i = sleepHead;
+        ticks -= tcb[i].ticks;
+        tickTime += tcb[i].ticks;
+        sleepHead = tcb[i].sleepNext;
+        if(sleepHead != NO_TASK)
+            tcb[sleepHead].sleepPrev = NO_TASK;
+        tcb[i].sleepNext = NO_TASK;
+        tcb[i].ticks = 0;
+        if(waitExpire(i))                           //timed wait or lock gave up
+        {
+            tcb[i].state = STATE_READY;
+            readyRelease(i);
+        }
+    }
+    tickTime += ticks;
+    if(sleepHead != NO_TASK)
+        tcb[sleepHead].ticks -= ticks;
+    if(tcb[taskCurrent].budget != 0)                //a task without a budget is charged when the window closes
+    {
+        runCharge();
+        if(budgetCheck())
+            reschedule();
+    }
+
+    cpuWindowTime += elapsed;
+    if(cpuWindowTime > CPU_WINDOW)
+    {
+        runCharge();                                //a task that kept the cpu all window long counts too
+        cpuWindowTime = 0;
+        pingpong = !pingpong;
+        for(i = 0; i < taskCount; i++)
+        {
+            if(pingpong)
+                tcb[i].timeA = 0;
+            else
+                tcb[i].timeB = 0;
+        }
+    }
+}
+
+// ticks until the kernel next needs the systick in tickless mode
+uint32_t tickNextPeriod(void)
+{
+    uint32_t n = MAX_TICKLESS_TICKS;
+    uint8_t level = getClz(readyBitmap);
+    if(preemption && level < NUM_LEVELS && !readyLevelSorted(level) && tcb[readyHead[level]].readyNext != NO_TASK)
+    {
+        if(tcb[taskCurrent].readyLevel == level)
+            n = tcb[taskCurrent].sliceLeft;         //peers take over when the slice runs out
+        else
+            n = 1;
+    }
+    if(CPU_WINDOW + 1 - cpuWindowTime < n)
+        n = CPU_WINDOW + 1 - cpuWindowTime;         //keep the ps window 500 ms long
+    if(sleepHead != NO_TASK && tcb[sleepHead].ticks < n)
+        n = tcb[sleepHead].ticks;
+    if(tcb[taskCurrent].budget != 0 && tcb[taskCurrent].readyLevel != NO_LEVEL)
+    {
+        uint32_t used = tcb[taskCurrent].budgetUsed + PORT_RUN_TIME();
+        uint32_t left = 0;
+        if(used < tcb[taskCurrent].budget)
+            left = (tcb[taskCurrent].budget - used) / TICK_CYCLES + 1;
+        if(left < n)
+            n = left;                               //throttle on time
+    }
+    if(n == 0)
+        n = 1;
+    return n;
+}
+
+// tickless: account for the whole ticks that passed since the period was programmed
+// the remainder is kept in tickOffset so wakeups stay on the 1 ms grid
+void ticklessSync(void)
+{
+    if(ticklessMode)
+    {
+        uint32_t current = PORT_TICK_CURRENT();
+        uint32_t cycles = tickOffset;
+        if(PORT_TICK_WRAPPED())                             //period already expired, isr still pending
+        {
+            current = PORT_TICK_CURRENT();
+            cycles += PORT_TICK_RELOAD() + 1;
+            PORT_TICK_CLEAR_PENDING();
+        }
+        cycles += PORT_TICK_RELOAD() - current;
+        uint32_t elapsed = cycles / TICK_CYCLES;
+        tickOffset = cycles - (elapsed * TICK_CYCLES);
+        tickAdvance(elapsed);
+    }
+}
+
+// tickless: program the systick as a one-shot ending on the tick of the next deadline
+void ticklessProgram(void)
+{
+    if(ticklessMode)
+    {
+        tickPeriod = tickNextPeriod();
+        PORT_TICK_SET((tickPeriod * TICK_CYCLES) - tickOffset - 1);
+    }
+}
+
+// REQUIRED: modify this function to add support for the system timer
+// REQUIRED: in preemptive code, add code to request task switch
+void systickIsr(void)               //goes off every ms, or at the next deadline when tickless
+{
+    uint32_t head = traceHead;
+    uint32_t requested = switchRequested;
+    uint32_t start = traceOn ? PORT_TRACE_TIME() : 0;
+    uint32_t cycles;
+    if(ticklessMode)
+    {
+        tickOffset = PORT_TICK_RELOAD() - PORT_TICK_CURRENT();     //isr latency since the period expired
+        tickAdvance(tickPeriod);
+        ticklessProgram();
+    }
+    else
+    {
+        tickAdvance(1);
+    }
+    if(preemption)
+    {
+        reschedule();
+    }
+    if(traceOn && (traceHead != head || switchRequested != requested))    //ticks that only count are left out
+    {
+        cycles = PORT_TRACE_TIME() - start;
+        traceRecord(TRACE_TICK, taskCurrent, (cycles > 0xFFFF) ? 0xFFFF : cycles);
+    }
+}
+
+// REQUIRED: in coop and preemptive, modify this function to add support for task switching
+// REQUIRED: process UNRUN and READY tasks differently
+PORT_NAKED
+void pendSvIsr(void)
+{
+    PORT_ENTER_CRITICAL();                          //no FromIsr call while the task changes or PSP is off its stacked R0
+    pushRegs();                                     //push SW regs
+    tcb[taskCurrent].sp = (void*)getPSP();          //sync tcb.sp w/ PSP
+    runCharge();
+    budgetCheck();
+    PORT_RUN_STOP();
+    taskPrevious = taskCurrent;
+    taskCurrent = rtosScheduler();                  //gets current task
+    if(taskCurrent != taskPrevious)
+    {
+        switchUseful++;
+        traceEvent(TRACE_SWITCH, taskCurrent, taskPrevious);
+    }
+    PORT_RUN_RESTART();
+    applySramAccessMask(tcb[taskCurrent].srd);
+    if(tcb[taskCurrent].state == STATE_UNRUN)
+    {
+        tcb[taskCurrent].state = STATE_READY;       //set state to ready
+        tcb[taskCurrent].sp = portStackInit(tcb[taskCurrent].sp, (_fn)tcb[taskCurrent].pid);
+    }
+    setPSP((uint32_t*)tcb[taskCurrent].sp);
+    PORT_EXIT_CRITICAL(0);                          //pendsv only runs from thread mode, where the mask is 0
+    popRegs();
+}
+
+void restart(uint8_t task)
+{
+uint32_t req_size = 0;
+    if(tcb[task].state == STATE_KILLED)
+    {
+        tcb[task].state = STATE_UNRUN;
+        tcb[task].currentPriority = tcb[task].priority;   //set priority to original prio
+        tcb[task].mutex = NO_MUTEX;
+        tcb[task].mutexHeld = NO_MUTEX;
+        tcb[task].semaphore = 0;
+        tcb[task].notifyValue = 0;
+        tcb[task].condition = NO_CONDITION;
+        tcb[task].readHeld = 0;
+        req_size = tcb[task].req_size;
+        uint32_t * base_add = mallocHeap(req_size);     //will return pointer of base address
+        global_srdMask = createNoSramAccessMask();
+        addSramAccessWindow(&global_srdMask, base_add, req_size);
+        uint32_t i_sp = ((uint32_t)base_add + req_size) & (~0x7);
+        tcb[task].sp = (void *)i_sp;     //store top of stack in sp
+        tcb[task].srd = global_srdMask;
+        tcb[task].nextRelease = tickTime;
+        readyRelease(task);
+    }
+}
+
+// REQUIRED: modify this function to add support for the service call
+// REQUIRED: in preemptive code, add code to handle synchronization primitives
+// true if flags satisfy a wait for wanted in mode
+bool eventMatch(uint32_t flags, uint32_t wanted, uint8_t mode)
+{
+    if(mode & EVENT_ALL)
+        return (flags & wanted) == wanted;
+    return (flags & wanted) != 0;
+}
+
+// set flags in group and wake every waiter they satisfy in one pass over its queue
+// flags waited for with EVENT_CLEAR are cleared after the pass, so all waiters see the same flags
+void eventSet(uint8_t group, uint32_t flags)
+{
+    uint32_t clear = 0;
+    uint8_t task = eventGroups[group].queue.head;
+    uint8_t next;
+    bool woke = false;
+    eventGroups[group].flags |= flags;
+    while(task != NO_TASK)
+    {
+        next = tcb[task].waitNext;
+        if(eventMatch(eventGroups[group].flags, tcb[task].eventFlags, tcb[task].eventMode))
+        {
+            if(tcb[task].eventMode & EVENT_CLEAR)
+                clear |= tcb[task].eventFlags;
+            waitRemove(&eventGroups[group].queue, task);
+            waitGranted(task, eventGroups[group].flags);
+            tcb[task].state = STATE_READY;
+            readyRelease(task);
+            woke = true;
+        }
+        task = next;
+    }
+    eventGroups[group].flags &= ~clear;
+    if(woke)
+        reschedule();
 }
 
-void killT(_fn pid)
+// with pi on, holders of a reader-writer lock inherit from the writers waiting on it,
+// a writer also from the waiting readers (the queues are priority ordered, the head is enough)
+uint8_t rwPriority(uint8_t task, uint8_t prio)
 {
-    uint8_t i = 0,j = 0;
-    for(i = 0; i < 12; i++)
+    uint8_t i, head;
+    for(i = 0; i < MAX_RWLOCKS; i++)
     {
-        if(tcb[i].pid == pid && tcb[i].state != STATE_KILLED)
+        if(rwLocks[i].valid && (rwLocks[i].writer == task || (tcb[task].readHeld & (1 << i))))
         {
-            freeHeapPid(tcb[i].pid);                   //memory freed
-            tcb[i].srd = createNoSramAccessMask();              //clear srd, base add, and sp
-            tcb[i].sp = NULL;
-            if(tcb[i].state == STATE_BLOCKED_MUTEX)             //removes from queue if blocked
-            {
-                for(j = 0;j < mutexes[0].queueSize; j++)
-                {
-                    if(mutexes[0].processQueue[j] == i)
-                    {
-                        if(j == 0)
-                        mutexes[0].processQueue[0] = mutexes[0].processQueue[1];
-                        mutexes[0].processQueue[1] = 0;
-                        mutexes[0].queueSize--;
-                        break;
-                    }
-                }
-            }
-            else if(tcb[i].state == STATE_BLOCKED_SEMAPHORE)
-            {
-                if(tcb[i].semaphore < MAX_SEMAPHORES)
-                {
-                    for(j = 0;j < semaphores[tcb[i].semaphore].queueSize; j++)
-                    {
-                        if(semaphores[tcb[i].semaphore].processQueue[j] == i)
-                        {
-                            if(j == 0)
-                            semaphores[tcb[i].semaphore].processQueue[0] = semaphores[tcb[i].semaphore].processQueue[1];
-                            semaphores[tcb[i].semaphore].processQueue[1] = 0;
-                            semaphores[tcb[i].semaphore].queueSize--;
-                            break;
-                        }
-                    }
-                }
-            }
-            tcb[i].state = STATE_KILLED;
-            if(i == taskCurrent)                    //task switch in case curr task is killed
-            {
-                NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
-            }
+            head = rwLocks[i].writeQueue.head;
+            if(head != NO_TASK && tcb[head].currentPriority < prio)
+                prio = tcb[head].currentPriority;
+            head = rwLocks[i].readQueue.head;
+            if(rwLocks[i].writer == task && head != NO_TASK && tcb[head].currentPriority < prio)
+                prio = tcb[head].currentPriority;
         }
     }
+    return prio;
 }
 
-// REQUIRED: modify this function to restart a thread, including creating a stack
-void restartThread(_fn fn)
+// bring the priority of every holder of rwLock up to date after its waiters changed
+void rwUpdateHolders(uint8_t rwLock)
 {
-    __asm(" SVC #16");
+    uint8_t i;
+    if(rwLocks[rwLock].writer != NO_TASK)
+        priorityUpdate(rwLocks[rwLock].writer);
+    for(i = 0; i < MAX_TASKS && rwLocks[rwLock].readers != 0; i++)
+    {
+        if(tcb[i].readHeld & (1 << rwLock))
+            priorityUpdate(i);
+    }
 }
 
-// REQUIRED: modify this function to set a thread priority
-void setThreadPriority(_fn fn, uint8_t priority)
+// true if a reader of priority prio may take rwLock now
+bool rwReadAdmit(uint8_t rwLock, uint8_t prio)
 {
-    __asm(" SVC #17");
+    uint8_t writer = rwLocks[rwLock].writeQueue.head;
+    if(rwLocks[rwLock].writer != NO_TASK)
+        return false;
+    if(writer == NO_TASK)
+        return true;
+    return !rwLocks[rwLock].writerPreference && prio < tcb[writer].currentPriority;
 }
 
-// REQUIRED: modify this function to yield execution back to scheduler using pendsv
-void yield(void)
+// hand rwLock to the waiters that may have it now: the first writer once no one holds it,
+// unless the readers may go first, then every reader that is admitted
+void rwAdmit(uint8_t rwLock)
 {
-    __asm(" SVC #0");
+    uint8_t task = rwLocks[rwLock].readQueue.head;
+    bool woke = false;
+    if(rwLocks[rwLock].writer != NO_TASK)
+        return;
+    if(rwLocks[rwLock].readers == 0 && rwLocks[rwLock].writeQueue.head != NO_TASK
+       && (task == NO_TASK || !rwReadAdmit(rwLock, tcb[task].currentPriority)))
+    {
+        task = waitDequeue(&rwLocks[rwLock].writeQueue);
+        rwLocks[rwLock].writer = task;
+        tcb[task].state = STATE_READY;
+        readyInsert(task);
+        traceEvent(TRACE_WAKE, task, 0);
+        priorityUpdate(task);                           //inherits from the remaining waiters
+        woke = true;
+    }
+    else
+    {
+        while(task != NO_TASK && rwReadAdmit(rwLock, tcb[task].currentPriority))
+        {
+            waitDequeue(&rwLocks[rwLock].readQueue);
+            rwLocks[rwLock].readers++;
+            tcb[task].readHeld |= 1 << rwLock;
+            tcb[task].state = STATE_READY;
+            readyInsert(task);
+            traceEvent(TRACE_WAKE, task, 0);
+            priorityUpdate(task);
+            woke = true;
+            task = rwLocks[rwLock].readQueue.head;
+        }
+    }
+    if(woke)
+        reschedule();
 }
 
-// REQUIRED: modify this function to support 1ms system timer
-// execution yielded back to scheduler until time elapses using pendsv
-void sleep(uint32_t tick)
+// task gives up its read or write hold on rwLock
+void rwRelease(uint8_t rwLock, uint8_t task)
 {
-    __asm(" SVC #1");
+    if(rwLocks[rwLock].writer == task)
+    {
+        rwLocks[rwLock].writer = NO_TASK;
+    }
+    else
+    {
+        tcb[task].readHeld &= ~(1 << rwLock);
+        rwLocks[rwLock].readers--;
+    }
+    priorityUpdate(task);                               //inherited priority dropped
+    rwAdmit(rwLock);
 }
 
-// REQUIRED: modify this function to wait a semaphore using pendsv
-void wait(int8_t semaphore)
+// a condition waiter was signalled or timed out, it runs again once it owns its mutex
+// while the mutex is locked the waiter joins its wait queue like a lock() caller (the owner inherits from it)
+// returns true if the mutex was free and the waiter owns it now
+bool condRelock(uint8_t task)
 {
-    __asm(" SVC #4");
+    uint8_t mutex = tcb[task].mutex;
+    if(mutexes[mutex].lock)
+    {
+        tcb[task].state = STATE_BLOCKED_MUTEX;
+        waitEnqueue(&mutexes[mutex].queue, task);
+        priorityUpdate(mutexes[mutex].lockedBy);
+        return false;
+    }
+    mutexAcquire(mutex, task);
+    tcb[task].mutex = NO_MUTEX;
+    tcb[task].condition = NO_CONDITION;
+    priorityUpdate(task);
+    return true;
 }
 
-// REQUIRED: modify this function to signal a semaphore is available using pendsv
-void post(int8_t semaphore)
+// wake the first (all = false) or every waiter of condition
+// the signaller usually holds the mutex, so the waiters move straight onto its wait queue
+// and take it one at a time as it is unlocked instead of all waking to race for it
+void condWake(uint8_t condition, bool all)
 {
-    __asm(" SVC #5");
+    uint8_t task = waitDequeue(&conditions[condition].queue);
+    while(task != NO_TASK)
+    {
+        waitGranted(task, true);
+        if(condRelock(task))
+        {
+            tcb[task].state = STATE_READY;
+            readyRelease(task);
+        }
+        task = all ? waitDequeue(&conditions[condition].queue) : NO_TASK;
+    }
+    reschedule();
 }
 
-// REQUIRED: modify this function to lock a mutex using pendsv
-void lock(int8_t mutex)
+// take the nonzero notification word of task as its pending takeNotify asked
+uint32_t notifyTake(uint8_t task)
 {
-    __asm(" SVC #2");
+    uint32_t value = tcb[task].notifyValue;
+    tcb[task].notifyValue = tcb[task].notifyClear ? 0 : value - 1;
+    return value;
 }
 
-// REQUIRED: modify this function to unlock a mutex using pendsv
-void unlock(int8_t mutex)
+// give semaphore to its first waiter, or count it if there is none
+void semaphorePost(uint8_t semaphore)
 {
-    __asm(" SVC #3");
+    uint8_t task = waitDequeue(&semaphores[semaphore].queue);
+    if(task != NO_TASK)
+    {
+        waitGranted(task, true);
+        tcb[task].state = STATE_READY;
+        readyRelease(task);
+        tcb[task].semaphore = 0;
+        reschedule();
+    }
+    else
+    {
+        semaphores[semaphore].count++;
+    }
 }
 
-// REQUIRED: modify this function to add support for the system timer
-// REQUIRED: in preemptive code, add code to request task switch
-void systickIsr(void)               //goes off every ms
+// notifyTask for the live task with pid, nothing if there is none
+void notifyPid(void *pid, uint32_t value, uint8_t action)
 {
-    uint8_t i = 0;
-    static uint32_t time = 0;
-    for(i = 0; i < taskCount; i++)
+    uint8_t task;
+    for(task = 0; task < MAX_TASKS; task++)
     {
-        if(tcb[i].state == STATE_DELAYED)           //if delayed increment ticks till 0
+        if(tcb[task].pid == pid && tcb[task].state != STATE_INVALID && tcb[task].state != STATE_KILLED)
         {
-            tcb[i].ticks--;
-            if(tcb[i].ticks == 0)
-            {
-                tcb[i].state = STATE_READY;
-            }
+            notifyTask(task, value, action);
+            break;
         }
     }
-    if(priorityInheritance && mutexes[0].lock)
+}
+
+// update the notification word of task and wake it if it waits for one
+void notifyTask(uint8_t task, uint32_t value, uint8_t action)
+{
+    if(action == NOTIFY_INCREMENT)
+        tcb[task].notifyValue++;
+    else if(action == NOTIFY_SET_BITS)
+        tcb[task].notifyValue |= value;
+    else if(action == NOTIFY_OVERWRITE)
+        tcb[task].notifyValue = value;
+    if(tcb[task].state == STATE_BLOCKED_NOTIFY && tcb[task].notifyValue != 0)
     {
-       uint8_t owner = mutexes[0].lockedBy;
-       uint8_t highprio = 100;
-       if(mutexes[0].queueSize != 0)
-       {
-           if(tcb[mutexes[0].processQueue[0]].currentPriority < tcb[mutexes[0].processQueue[1]].currentPriority)
-               highprio = tcb[mutexes[0].processQueue[0]].currentPriority;
-           else
-               highprio = tcb[mutexes[0].processQueue[1]].currentPriority;
-           if(highprio < tcb[owner].priority)
-           {
-               tcb[owner].currentPriority = highprio;
-           }
-           else
-           {
-               tcb[owner].currentPriority = tcb[owner].priority;
-           }
-       }
+        waitGranted(task, notifyTake(task));
+        tcb[task].state = STATE_READY;
+        readyRelease(task);
+        reschedule();
     }
+}
 
-    time++;
-    if(time > 500)
+// item copy, a single load and store for word sized items
+void msgCopy(void *dest, const void *source, uint8_t size)
+{
+    uint8_t i;
+    if(size == 4)
     {
-        time = 0;
-        pingpong = !pingpong;
-        for(i = 0; i < taskCount; i++)
-        {
-            if(pingpong)
-                tcb[i].timeA = 0;
-            else
-                tcb[i].timeB = 0;
-        }
+        *(uint32_t*)dest = *(const uint32_t*)source;
     }
-    if(preemption)
+    else
     {
-        NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
+        for(i = 0; i < size; i++)
+            ((uint8_t*)dest)[i] = ((const uint8_t*)source)[i];
     }
 }
 
-// REQUIRED: in coop and preemptive, modify this function to add support for task switching
-// REQUIRED: process UNRUN and READY tasks differently
-__attribute__((naked))
-void pendSvIsr(void)
+// a mailbox buffer leaves task: its window closes and the kernel owns it until it is received
+void mailTake(uint8_t task, const void *item)
 {
-    pushRegs();                                     //push SW regs
-    tcb[taskCurrent].sp = (void*)getPSP();          //sync tcb.sp w/ PSP
-    if(pingpong)
-        tcb[taskCurrent].timeA += WTIMER0_TAV_R;
-    else
-        tcb[taskCurrent].timeB += WTIMER0_TAV_R;
-    WTIMER0_CTL_R &= ~TIMER_CTL_TAEN;
-    taskCurrent = rtosScheduler();                  //gets current task
-    WTIMER0_TAV_R = 0;
-    WTIMER0_CTL_R |= TIMER_CTL_TAEN;
-    applySramAccessMask(tcb[taskCurrent].srd);
-    if(tcb[taskCurrent].state == STATE_UNRUN)
+    void *buffer = (void*)(uintptr_t)*(const uint32_t*)item;
+    remSramAccessWindow(&tcb[task].srd, buffer, getHeapSize(buffer));
+    setHeapOwner(buffer, NO_TASK, NULL);
+    if(task == taskCurrent)
+        applySramAccessMask(tcb[task].srd);
+}
+
+// a mailbox buffer arrives at task: it becomes the owner and the buffer's window opens
+void mailGive(uint8_t task, const void *item)
+{
+    void *buffer = (void*)(uintptr_t)*(const uint32_t*)item;
+    addSramAccessWindow(&tcb[task].srd, buffer, getHeapSize(buffer));
+    setHeapOwner(buffer, task, tcb[task].pid);
+    if(task == taskCurrent)
+        applySramAccessMask(tcb[task].srd);
+}
+
+// hand item from the running task to the first waiting receiver or store it in the ring
+// returns false if the queue is full
+bool msgSend(uint8_t queue, const void *item)
+{
+    msgQueue *q = &msgQueues[queue];
+    uint8_t task;
+    if(q->count == q->depth)
+        return false;
+    if(q->mailbox)
+        mailTake(taskCurrent, item);
+    task = waitDequeue(&q->receivers);
+    if(task != NO_TASK)
     {
-        tcb[taskCurrent].state = STATE_READY;       //set state to ready
-        uint32_t * sp = (uint32_t *)tcb[taskCurrent].sp;
-        sp -= 17;
-        sp[0] = 0xFFFFFFFD;                         //LR Exception Result   lowest mem address
-        sp[1] = 111;                                //R4
-        sp[2] = 110;
-        sp[3] = 109;
-        sp[4] = 108;
-        sp[5] = 107;
-        sp[6] = 106;
-        sp[7] = 105;
-        sp[8] = 104;                                //R11
-        sp[9] = 100;                                //R0
-        sp[10] = 101;
-        sp[11] = 102;
-        sp[12] = 103;                               //R3
-        sp[13] = 112;                               //R12
-        sp[14] = 0x11111111;                        //LR
-        sp[15] = (uint32_t)tcb[taskCurrent].pid;    //PC
-        sp[16] = 0x01000000;                        //xPSR      highest mem address
-        tcb[taskCurrent].sp = (void*)sp;            //update tcb.sp
+        msgCopy(tcb[task].message, item, q->itemSize);     //receivers only wait on an empty ring
+        if(q->mailbox)
+            mailGive(task, item);
+        waitGranted(task, true);
+        tcb[task].state = STATE_READY;
+        readyRelease(task);
+        reschedule();
+        return true;
     }
-    setPSP((uint32_t*)tcb[taskCurrent].sp);
-    popRegs();
+    msgCopy(&q->buffer[((q->head + q->count) % q->depth) * q->itemSize], item, q->itemSize);
+    q->count++;
+    return true;
 }
 
-void restart(uint8_t task)
+// take the oldest item of the ring into item for the running task and let the first waiting sender refill the slot
+// returns false if the queue is empty
+bool msgReceive(uint8_t queue, void *item)
 {
-uint32_t req_size = 0;
-    if(tcb[task].state == STATE_KILLED)
+    msgQueue *q = &msgQueues[queue];
+    uint8_t *slot;
+    uint8_t task;
+    if(q->count == 0)
+        return false;
+    slot = &q->buffer[q->head * q->itemSize];
+    if(q->mailbox)
+        mailGive(taskCurrent, slot);
+    msgCopy(item, slot, q->itemSize);
+    q->head = (q->head + 1) % q->depth;
+    q->count--;
+    task = waitDequeue(&q->senders);
+    if(task != NO_TASK)
     {
-        tcb[task].state = STATE_UNRUN;
-        tcb[task].currentPriority = tcb[task].priority;   //set priority to original prio
-        tcb[task].mutex = 0;
-        tcb[task].semaphore = 0;
-        req_size = tcb[task].req_size;
-        uint32_t * base_add = mallocHeap(req_size);     //will return pointer of base address
-        global_srdMask = createNoSramAccessMask();
-        addSramAccessWindow(&global_srdMask, base_add, req_size);
-        uint32_t i_sp = ((uint32_t)base_add + req_size) & (~0x7);
-        tcb[task].sp = (void *)i_sp;     //store top of stack in sp
-        tcb[task].srd = global_srdMask;
+        if(q->mailbox)
+            mailTake(task, tcb[task].message);
+        msgCopy(&q->buffer[((q->head + q->count) % q->depth) * q->itemSize], tcb[task].message, q->itemSize);
+        q->count++;
+        waitGranted(task, true);
+        tcb[task].state = STATE_READY;
+        readyRelease(task);
+        reschedule();
     }
+    return true;
 }
 
-// REQUIRED: modify this function to add support for the service call
-// REQUIRED: in preemptive code, add code to handle synchronization primitives
 void svCallIsr(void)
 {
     uint32_t * psp = getPSP();
     uint8_t *pc = (uint8_t*) psp[6];
     uint32_t R0 = psp[0];
     uint32_t R1 = psp[1];
+    uint32_t R2 = psp[2];
+    uint32_t R3 = psp[3];
     uint32_t PID = 0;
     uint32_t tasktime = 0;
     uint64_t totaltime = 0;
     uint8_t num = *(pc - 2);
     uint8_t ID = (uint8_t)R0;
     uint8_t i = 0, j = 0;
+    uint32_t timeout;
     IPCS_INFO *IPSCdata;
     PS_INFO *PSdata;
     char * name;
+    void * item;
     bool power;
     _fn fn;
+    traceEvent(TRACE_SVC, taskCurrent, num);
+    ticklessSync();                 //bring sleepers up to date before changing kernel state
     switch(num)
     {
     case YIELD:
-        NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
+        readyRotate(taskCurrent);
+        reschedule();
         break;
     case SLEEP:
-        tcb[taskCurrent].ticks = R0;
+        sleepInsert(taskCurrent, R0);
         tcb[taskCurrent].state = STATE_DELAYED;
-        NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
+        readyRemove(taskCurrent);
+        traceEvent(TRACE_BLOCK, taskCurrent, STATE_DELAYED);
+        reschedule();
+        break;
+    case WAITPERIOD:
+        if(tcb[taskCurrent].period != 0)
+        {
+            tcb[taskCurrent].nextRelease += tcb[taskCurrent].period;
+            if((int32_t)(tcb[taskCurrent].nextRelease - tickTime) > 0)
+            {
+                sleepInsert(taskCurrent, tcb[taskCurrent].nextRelease - tickTime);
+                tcb[taskCurrent].state = STATE_DELAYED;
+                readyRemove(taskCurrent);
+                traceEvent(TRACE_BLOCK, taskCurrent, STATE_DELAYED);
+            }
+            else
+            {
+                if(tcb[taskCurrent].nextRelease != tickTime)
+                    tcb[taskCurrent].overruns++;        //release already passed, job starts late
+                while((int32_t)(tcb[taskCurrent].nextRelease + tcb[taskCurrent].period - tickTime) <= 0)
+                {
+                    tcb[taskCurrent].nextRelease += tcb[taskCurrent].period;   //releases missed entirely
+                    tcb[taskCurrent].overruns++;
+                }
+                tcb[taskCurrent].absDeadline = tcb[taskCurrent].nextRelease + tcb[taskCurrent].deadline;
+                readyRemove(taskCurrent);               //edf position follows the new deadline
+                readyInsert(taskCurrent);
+            }
+            reschedule();
+        }
         break;
     case LOCK:
+    case LOCKTIMEOUT:
+        timeout = (num == LOCKTIMEOUT) ? R1 : WAIT_FOREVER;
+        psp[0] = false;                                     //returned on timeout, set to true on handoff
         if(ID < MAX_MUTEXES)
         {
             if(mutexes[ID].lock == true)
             {
-                if(mutexes[ID].queueSize < MAX_MUTEX_QUEUE_SIZE)
+                if(timeout != 0)
                 {
                     tcb[taskCurrent].state = STATE_BLOCKED_MUTEX;   //task state to blocked
-                    tcb[taskCurrent].mutex = ID;
-                    mutexes[ID].processQueue[mutexes[ID].queueSize] = taskCurrent;
-                    mutexes[ID].queueSize++;
-                    NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
+                    readyRemove(taskCurrent);
+                    traceEvent(TRACE_BLOCK, taskCurrent, STATE_BLOCKED_MUTEX);
+                    tcb[taskCurrent].mutex = ID;                //blocked on
+                    waitEnqueue(&mutexes[ID].queue, taskCurrent);
+                    if(timeout != WAIT_FOREVER)
+                        sleepInsert(taskCurrent, timeout);
+                    priorityUpdate(mutexes[ID].lockedBy);       //owner inherits right away, down the chain
+                    reschedule();
                 }
             }
             else
             {
-                mutexes[ID].lock = true;
-                mutexes[ID].lockedBy = taskCurrent;
-                tcb[taskCurrent].mutex = ID;                //ownership recorded in tcb
+                mutexAcquire(ID, taskCurrent);              //ownership recorded in the task's held list
+                priorityUpdate(taskCurrent);                //raised to the ceiling right away
+                psp[0] = true;
             }
         }
         break;
     case UNLOCK:
-        if((mutexes[ID].lockedBy == taskCurrent) && (ID < MAX_MUTEXES))
+        if((ID < MAX_MUTEXES) && mutexes[ID].lock && (mutexes[ID].lockedBy == taskCurrent))
         {
-            mutexes[ID].lock = false;
-            mutexes[ID].lockedBy = 0;
-            tcb[taskCurrent].mutex = 0;
-            if(mutexes[ID].queueSize > 0)
-            {
-                mutexes[ID].lock = true;
-                mutexes[ID].lockedBy = mutexes[ID].processQueue[0];
-                tcb[mutexes[ID].processQueue[0]].mutex = 0;
-                tcb[mutexes[ID].processQueue[0]].state = STATE_READY;
-                mutexes[ID].processQueue[0] = mutexes[ID].processQueue[1];
-                mutexes[ID].queueSize--;
-                NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
-            }
+            mutexRelease(ID);
+            priorityUpdate(taskCurrent);                    //ceiling or inherited priority dropped
+            reschedule();
         }
         else
         {
             killThread((_fn)tcb[taskCurrent].pid);
-            NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
+            reschedule();
         }
         break;
     case WAIT:
+    case WAITTIMEOUT:
+        timeout = (num == WAITTIMEOUT) ? R1 : WAIT_FOREVER;
+        psp[0] = false;                                     //returned on timeout, set to true by post
+        if(ID >= MAX_SEMAPHORES)
+            break;
         if(semaphores[ID].count > 0)
         {
             semaphores[ID].count --;
+            psp[0] = true;
         }
-        else
+        else if(timeout != 0)
         {
             tcb[taskCurrent].state = STATE_BLOCKED_SEMAPHORE;
+            readyRemove(taskCurrent);
+            traceEvent(TRACE_BLOCK, taskCurrent, STATE_BLOCKED_SEMAPHORE);
             tcb[taskCurrent].semaphore = ID;
-            semaphores[ID].processQueue[semaphores[ID].queueSize] = taskCurrent;
-            semaphores[ID].queueSize++;
-            NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
+            waitEnqueue(&semaphores[ID].queue, taskCurrent);
+            if(timeout != WAIT_FOREVER)
+                sleepInsert(taskCurrent, timeout);
+            reschedule();
         }
         break;
     case POST:
-        if(semaphores[ID].queueSize > 0)
+        if(ID < MAX_SEMAPHORES)
+            semaphorePost(ID);
+        break;
+    case SETEVENTS:
+        if(ID < MAX_EVENT_GROUPS && eventGroups[ID].valid)
+            eventSet(ID, R1);
+        break;
+    case CLEAREVENTS:
+        if(ID < MAX_EVENT_GROUPS && eventGroups[ID].valid)
+            eventGroups[ID].flags &= ~R1;
+        break;
+    case WAITEVENTS:
+        psp[0] = 0;                                         //returned on timeout, set by eventSet
+        if(ID >= MAX_EVENT_GROUPS || !eventGroups[ID].valid || R1 == 0)
+            break;                                          //no flags would match at once for EVENT_ALL, never for any
+        if(eventMatch(eventGroups[ID].flags, R1, R2))
+        {
+            psp[0] = eventGroups[ID].flags;
+            if(R2 & EVENT_CLEAR)
+                eventGroups[ID].flags &= ~R1;
+        }
+        else if(R3 != 0)
+        {
+            tcb[taskCurrent].state = STATE_BLOCKED_EVENT;
+            readyRemove(taskCurrent);
+            traceEvent(TRACE_BLOCK, taskCurrent, STATE_BLOCKED_EVENT);
+            tcb[taskCurrent].event = ID;
+            tcb[taskCurrent].eventFlags = R1;
+            tcb[taskCurrent].eventMode = R2;
+            waitEnqueue(&eventGroups[ID].queue, taskCurrent);
+            if(R3 != WAIT_FOREVER)
+                sleepInsert(taskCurrent, R3);
+            reschedule();
+        }
+        break;
+    case SEND:
+    case SENDWORD:
+        psp[0] = false;                                     //returned on timeout, set by msgReceive
+        if(ID >= MAX_MSG_QUEUES || !msgQueues[ID].valid)
+            break;
+        if(num == SENDWORD && msgQueues[ID].itemSize != sizeof(uint32_t))
+            break;                                          //the stacked R1 holds one word, not a whole item
+        item = (num == SENDWORD) ? (void*)&psp[1] : (void*)(uintptr_t)R1;   //a word is sent from the stacked R1
+        if(msgQueues[ID].mailbox && getHeapOwner((void*)(uintptr_t)*(uint32_t*)item) != tcb[taskCurrent].pid)
+            break;                                          //only the owner can send a buffer
+        if(msgSend(ID, item))
+        {
+            psp[0] = true;
+        }
+        else if(R2 != 0)
+        {
+            tcb[taskCurrent].state = STATE_BLOCKED_SEND;
+            readyRemove(taskCurrent);
+            traceEvent(TRACE_BLOCK, taskCurrent, STATE_BLOCKED_SEND);
+            tcb[taskCurrent].msgQueue = ID;
+            tcb[taskCurrent].message = item;                //stays valid on the blocked task's stack
+            waitEnqueue(&msgQueues[ID].senders, taskCurrent);
+            if(R2 != WAIT_FOREVER)
+                sleepInsert(taskCurrent, R2);
+            reschedule();
+        }
+        break;
+    case ALLOCMAIL:
+        item = mallocHeap(R0);                              //owned by the running task
+        if(item != NULL)
+        {
+            addSramAccessWindow(&tcb[taskCurrent].srd, item, R0);
+            applySramAccessMask(tcb[taskCurrent].srd);
+        }
+        psp[0] = (uint32_t)(uintptr_t)item;
+        break;
+    case FREEMAIL:
+        item = (void*)(uintptr_t)R0;
+        if(item != NULL && getHeapOwner(item) == tcb[taskCurrent].pid)
+        {
+            remSramAccessWindow(&tcb[taskCurrent].srd, item, getHeapSize(item));
+            applySramAccessMask(tcb[taskCurrent].srd);
+            freeHeap(item);
+        }
+        break;
+    case RECEIVE:
+        psp[0] = false;                                     //returned on timeout, set by msgSend
+        if(ID >= MAX_MSG_QUEUES || !msgQueues[ID].valid)
+            break;
+        if(msgReceive(ID, (void*)(uintptr_t)R1))
+        {
+            psp[0] = true;
+        }
+        else if(R2 != 0)
+        {
+            tcb[taskCurrent].state = STATE_BLOCKED_RECEIVE;
+            readyRemove(taskCurrent);
+            traceEvent(TRACE_BLOCK, taskCurrent, STATE_BLOCKED_RECEIVE);
+            tcb[taskCurrent].msgQueue = ID;
+            tcb[taskCurrent].message = (void*)(uintptr_t)R1;
+            waitEnqueue(&msgQueues[ID].receivers, taskCurrent);
+            if(R2 != WAIT_FOREVER)
+                sleepInsert(taskCurrent, R2);
+            reschedule();
+        }
+        break;
+    case READLOCK:
+        if(ID >= MAX_RWLOCKS || !rwLocks[ID].valid || (tcb[taskCurrent].readHeld & (1 << ID)))
+            break;
+        if(rwReadAdmit(ID, tcb[taskCurrent].currentPriority))
+        {
+            rwLocks[ID].readers++;
+            tcb[taskCurrent].readHeld |= 1 << ID;
+            priorityUpdate(taskCurrent);                    //inherits from writers already waiting
+        }
+        else
+        {
+            tcb[taskCurrent].state = STATE_BLOCKED_READ;
+            readyRemove(taskCurrent);
+            traceEvent(TRACE_BLOCK, taskCurrent, STATE_BLOCKED_READ);
+            tcb[taskCurrent].rwLock = ID;
+            waitEnqueue(&rwLocks[ID].readQueue, taskCurrent);
+            rwUpdateHolders(ID);                            //a writer owner inherits right away
+            reschedule();
+        }
+        break;
+    case WRITELOCK:
+        if(ID >= MAX_RWLOCKS || !rwLocks[ID].valid || rwLocks[ID].writer == taskCurrent)
+            break;
+        if(rwLocks[ID].writer == NO_TASK && rwLocks[ID].readers == 0)
+        {
+            rwLocks[ID].writer = taskCurrent;
+        }
+        else
         {
-            tcb[semaphores[ID].processQueue[0]].state = STATE_READY;
-            tcb[semaphores[ID].processQueue[0]].semaphore = 0;
-            semaphores[ID].processQueue[0] = semaphores[ID].processQueue[1];
-            semaphores[ID].processQueue[1] = 0;
-            semaphores[ID].queueSize--;
-            NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
+            tcb[taskCurrent].state = STATE_BLOCKED_WRITE;
+            readyRemove(taskCurrent);
+            traceEvent(TRACE_BLOCK, taskCurrent, STATE_BLOCKED_WRITE);
+            tcb[taskCurrent].rwLock = ID;
+            waitEnqueue(&rwLocks[ID].writeQueue, taskCurrent);
+            rwUpdateHolders(ID);                            //every reader or the writer inherits right away
+            reschedule();
+        }
+        break;
+    case READUNLOCK:
+    case WRITEUNLOCK:
+        if(ID < MAX_RWLOCKS && (num == READUNLOCK ? (tcb[taskCurrent].readHeld & (1 << ID)) != 0
+                                                  : rwLocks[ID].writer == taskCurrent))
+        {
+            rwRelease(ID, taskCurrent);
+            reschedule();
         }
         else
         {
-            semaphores[ID].count++;
+            killThread((_fn)tcb[taskCurrent].pid);
+            reschedule();
+        }
+        break;
+    case CONDWAIT:                      //condWait(uint8_t condition, int8_t mutex, uint32_t ticks)
+        psp[0] = false;                                     //returned on timeout, set to true by condWake
+        if(ID >= MAX_CONDITIONS || !conditions[ID].valid || R1 >= MAX_MUTEXES)
+            break;
+        if(!mutexes[R1].lock || mutexes[R1].lockedBy != taskCurrent || R2 == 0)
+            break;
+        tcb[taskCurrent].state = STATE_BLOCKED_CONDITION;
+        readyRemove(taskCurrent);
+        traceEvent(TRACE_BLOCK, taskCurrent, STATE_BLOCKED_CONDITION);
+        tcb[taskCurrent].condition = ID;
+        tcb[taskCurrent].mutex = R1;                        //relocked when woken
+        waitEnqueue(&conditions[ID].queue, taskCurrent);
+        if(R2 != WAIT_FOREVER)
+            sleepInsert(taskCurrent, R2);
+        mutexRelease(R1);                                   //next lock() waiter gets it
+        priorityUpdate(taskCurrent);                        //ceiling or inherited priority dropped
+        reschedule();
+        break;
+    case CONDSIGNAL:
+    case CONDBROADCAST:
+        if(ID < MAX_CONDITIONS && conditions[ID].valid)
+            condWake(ID, num == CONDBROADCAST);
+        break;
+    case NOTIFY:                        //notify(_fn fn, uint32_t value, uint8_t action)
+        notifyPid((void*)R0, R1, R2);
+        break;
+    case TAKENOTIFY:                    //takeNotify(bool clear, uint32_t ticks)
+        psp[0] = 0;                                         //returned on timeout, set by notifyTask
+        tcb[taskCurrent].notifyClear = (bool)R0;
+        if(tcb[taskCurrent].notifyValue != 0)
+        {
+            psp[0] = notifyTake(taskCurrent);
+        }
+        else if(R1 != 0)
+        {
+            tcb[taskCurrent].state = STATE_BLOCKED_NOTIFY;
+            readyRemove(taskCurrent);
+            traceEvent(TRACE_BLOCK, taskCurrent, STATE_BLOCKED_NOTIFY);
+            if(R1 != WAIT_FOREVER)
+                sleepInsert(taskCurrent, R1);
+            reschedule();
         }
         break;
     case PI:
@@ -612,13 +2208,30 @@ void svCallIsr(void)
             priorityInheritance = true;
         else
             priorityInheritance = false;
+        power = false;
+        for(i = 0; i < MAX_MUTEXES; i++)
+        {
+            if(mutexes[i].lock)
+            {
+                priorityUpdate(mutexes[i].lockedBy);
+                power = true;
+            }
+        }
+        for(i = 0; i < MAX_RWLOCKS; i++)
+        {
+            if(rwLocks[i].valid && (rwLocks[i].writer != NO_TASK || rwLocks[i].readers != 0))
+            {
+                rwUpdateHolders(i);
+                power = true;
+            }
+        }
+        if(power)
+            reschedule();                   //no owners before startRtos, so no switch is pended from main
         break;
     case SCHED:
-        power = (bool)R0;
-        if(power)
-            priorityScheduler = true;       //1 is prio
-        else
-            priorityScheduler = false;      //0 is rr
+        priorityScheduler = (R0 != SCHED_RR);   //edf schedules tasks without a deadline by priority
+        edfScheduler = (R0 == SCHED_EDF);
+        readyRebuild();
         break;
     case PREEMPT:
         power = (bool)R0;
@@ -628,7 +2241,7 @@ void svCallIsr(void)
             preemption = false;
         break;
     case REBOOT:
-        NVIC_APINT_R = (NVIC_APINT_VECTKEY | 4);
+        PORT_RESET();
         break;
     case PIDOF:
         name = (char*)R0;
@@ -639,7 +2252,7 @@ void svCallIsr(void)
             {
                 power = true;
                 psp[0] = (uint32_t)tcb[i].pid;
-                return;
+                break;
             }
         }
         if(!power)
@@ -651,39 +2264,95 @@ void svCallIsr(void)
         IPSCdata = (IPCS_INFO*)R0;
 
         //fill mutex data
-        IPSCdata->mutexes[0].lock = mutexes[0].lock;
-        if(mutexes[0].lock)
+        for(i = 0; i < MAX_MUTEXES; i++)
         {
-            char* source = tcb[mutexes[0].lockedBy].name;
-            char* dest = IPSCdata->mutexes[0].lockedBy;
-            for(i = 0; (i < 15 && source[i] != 0); i++)
+            IPSCdata->mutexes[i].valid = mutexes[i].valid || mutexes[i].lock;
+            IPSCdata->mutexes[i].lock = mutexes[i].lock;
+            IPSCdata->mutexes[i].ceiling = mutexes[i].ceiling;
+            IPSCdata->mutexes[i].queueSize = mutexes[i].queue.size;
+            char* source = tcb[mutexes[i].lockedBy].name;
+            char* dest = IPSCdata->mutexes[i].lockedBy;
+            for(j = 0; (mutexes[i].lock && j < 15 && source[j] != 0); j++)
             {
-                dest[i] = source[i];
+                dest[j] = source[j];
+            }
+            dest[j] = 0;
+            source = tcb[mutexes[i].queue.head].name;
+            dest = IPSCdata->mutexes[i].processQueue;
+            for(j = 0; (mutexes[i].queue.size != 0 && j < 15 && source[j] != 0); j++)
+            {
+                dest[j] = source[j];
             }
-            dest[i] = 0;
+            dest[j] = 0;
         }
-        else
+
+        //fill event group data
+        for(i = 0; i < MAX_EVENT_GROUPS; i++)
+        {
+            IPSCdata->events[i].valid = eventGroups[i].valid;
+            IPSCdata->events[i].flags = eventGroups[i].flags;
+            IPSCdata->events[i].queueSize = eventGroups[i].queue.size;
+            char* source = tcb[eventGroups[i].queue.head].name;
+            char* dest = IPSCdata->events[i].processQueue;
+            for(j = 0; (eventGroups[i].queue.size != 0 && j < 15 && source[j] != 0); j++)
+            {
+                dest[j] = source[j];
+            }
+            dest[j] = 0;
+        }
+
+        //fill reader-writer lock data
+        for(i = 0; i < MAX_RWLOCKS; i++)
+        {
+            IPSCdata->rwLocks[i].valid = rwLocks[i].valid;
+            IPSCdata->rwLocks[i].writerPreference = rwLocks[i].writerPreference;
+            IPSCdata->rwLocks[i].readers = rwLocks[i].readers;
+            IPSCdata->rwLocks[i].readWaiting = rwLocks[i].readQueue.size;
+            IPSCdata->rwLocks[i].writeWaiting = rwLocks[i].writeQueue.size;
+            char* source = tcb[rwLocks[i].writer].name;
+            char* dest = IPSCdata->rwLocks[i].writer;
+            for(j = 0; (rwLocks[i].writer != NO_TASK && j < 15 && source[j] != 0); j++)
+            {
+                dest[j] = source[j];
+            }
+            dest[j] = 0;
+        }
+
+        //fill condition variable data
+        for(i = 0; i < MAX_CONDITIONS; i++)
         {
-            IPSCdata->mutexes[0].lockedBy[0] = '\0';
+            IPSCdata->conditions[i].valid = conditions[i].valid;
+            IPSCdata->conditions[i].queueSize = conditions[i].queue.size;
+            char* source = tcb[conditions[i].queue.head].name;
+            char* dest = IPSCdata->conditions[i].processQueue;
+            for(j = 0; (conditions[i].queue.size != 0 && j < 15 && source[j] != 0); j++)
+            {
+                dest[j] = source[j];
+            }
+            dest[j] = 0;
         }
 
-        IPSCdata->mutexes[0].queueSize = mutexes[0].queueSize;
-        char* source = tcb[mutexes[0].processQueue[0]].name;
-        char* dest = IPSCdata->mutexes[0].processQueue[0];
-        for(i = 0; (i < 15 && source[i] != 0); i++)
+        //fill message queue data
+        for(i = 0; i < MAX_MSG_QUEUES; i++)
         {
-            dest[i] = source[i];
+            IPSCdata->msgQueues[i].valid = msgQueues[i].valid;
+            IPSCdata->msgQueues[i].depth = msgQueues[i].depth;
+            IPSCdata->msgQueues[i].itemSize = msgQueues[i].itemSize;
+            IPSCdata->msgQueues[i].mailbox = msgQueues[i].mailbox;
+            IPSCdata->msgQueues[i].count = msgQueues[i].count;
+            IPSCdata->msgQueues[i].buffer = (uint32_t)(uintptr_t)msgQueues[i].buffer;
+            IPSCdata->msgQueues[i].senders = msgQueues[i].senders.size;
+            IPSCdata->msgQueues[i].receivers = msgQueues[i].receivers.size;
         }
-        dest[i] = 0;
 
         //fill semaphore data
         for(i = 0; i < MAX_SEMAPHORES; i++)
         {
             IPSCdata->semaphores[i].count = semaphores[i].count;
-            IPSCdata->semaphores[i].queueSize = semaphores[i].queueSize;
-            char* source = tcb[semaphores[i].processQueue[0]].name;
-            char* dest = IPSCdata->semaphores[i].processQueue[0];
-            for(j = 0;(j < 15 && source[j] != 0); j++)
+            IPSCdata->semaphores[i].queueSize = semaphores[i].queue.size;
+            char* source = tcb[semaphores[i].queue.head].name;
+            char* dest = IPSCdata->semaphores[i].processQueue;
+            for(j = 0;(semaphores[i].queue.size != 0 && j < 15 && source[j] != 0); j++)
             {
                 dest[j] = source[j];
             }
@@ -692,7 +2361,12 @@ void svCallIsr(void)
         break;
     case PS:
         PSdata = (PS_INFO*)R0;
+        runCharge();                                        //the caller's time up to now, it may not have switched all window
         totaltime = 0;
+        PSdata->time = tickTime;
+        PSdata->switchRequested = switchRequested;
+        PSdata->switchAvoided = switchAvoided;
+        PSdata->switchUseful = switchUseful;
         for(i = 0; i < taskCount; i++)
         {
             if(pingpong)
@@ -703,8 +2377,11 @@ void svCallIsr(void)
         for(i = 0; i < MAX_TASKS; i++)
         {
             PSdata->tasks[i].pid = tcb[i].pid;
-            PSdata->tasks[i].ticks = tcb[i].ticks;
+            PSdata->tasks[i].ticks = sleepRemaining(i);
             PSdata->tasks[i].state = tcb[i].state;
+            PSdata->tasks[i].deadline = tcb[i].absDeadline;
+            PSdata->tasks[i].hasDeadline = (tcb[i].deadline != 0);
+            PSdata->tasks[i].overruns = tcb[i].overruns;
 
             if(pingpong)
                 tasktime = tcb[i].timeA;
@@ -773,17 +2450,85 @@ void svCallIsr(void)
     case TPRIO:                         //setThreadPriority(_fn fn, uint8_t priority)
         fn = (_fn)R0;
         uint8_t prio = (uint8_t)R1;
+        if(R1 >= NUM_PRIORITIES)
+            break;
+        for(i = 0; i < taskCount; i++)
+        {
+            if(tcb[i].pid == fn)    //task found
+            {
+                tcb[i].priority = prio;
+                priorityUpdate(i);                  //keeps a ceiling or inherited priority, passes a change on to its owner
+                break;
+            }
+        }
+        break;
+    case TQUANTUM:                      //setThreadQuantum(_fn fn, uint32_t ticks)
+        fn = (_fn)R0;
+        for(i = 0; i < taskCount; i++)
+        {
+            if(tcb[i].pid == fn)    //task found
+            {
+                tcb[i].quantum = R1;
+                break;
+            }
+        }
+        break;
+    case PQUANTUM:                      //setPriorityQuantum(uint8_t priority, uint32_t ticks)
+        if(R0 < NUM_PRIORITIES && R1 != 0)
+            priorityQuantum[R0] = R1;
+        break;
+    case TBUDGET:                       //setThreadBudget(_fn fn, uint32_t us, uint32_t period)
+        fn = (_fn)R0;
+        for(i = 0; i < taskCount; i++)
+        {
+            if(tcb[i].pid == fn)    //task found
+            {
+                tcb[i].budget = R1 * CYCLES_PER_US;
+                tcb[i].budgetPeriod = (R2 != 0) ? R2 : 1;
+                tcb[i].budgetNext = tickTime + tcb[i].budgetPeriod;
+                tcb[i].budgetUsed = 0;
+                break;
+            }
+        }
+        break;
+    case TRACE:                         //traceCtl(uint8_t command, TRACE_INFO *info)
+        traceControl((uint8_t)R0, (TRACE_INFO*)R1);
+        break;
+    case TDEADLINE:                     //setThreadDeadline(_fn fn, uint32_t deadline)
+        fn = (_fn)R0;
         for(i = 0; i < taskCount; i++)
         {
             if(tcb[i].pid == fn)    //task found
             {
-                tcb[i].currentPriority = prio;      //update current prio
+                tcb[i].deadline = R1;
+                tcb[i].absDeadline = tickTime + R1;
+                if(tcb[i].readyLevel != NO_LEVEL)
+                {
+                    readyRemove(i);                 //level and edf position may change
+                    readyInsert(i);
+                }
                 break;
             }
         }
         break;
+    case TICKLESS:
+        power = (bool)R0;
+        if(power && !ticklessMode)
+        {
+            tickOffset = PORT_TICK_RELOAD() - PORT_TICK_CURRENT();     //cycles into the current 1 ms tick
+            ticklessMode = true;
+        }
+        else if(!power && ticklessMode)
+        {
+            ticklessMode = false;                                    //back to a 1 ms reload
+            tickPeriod = 1;
+            tickOffset = 0;
+            PORT_TICK_SET(TICK_CYCLES - 1);
+        }
+        break;
     }
-    //NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV;
+    ticklessProgram();              //next deadline may have moved
+    traceEvent(TRACE_RETURN, taskCurrent, num);
 }
 
 
@@ -27,23 +27,69 @@ typedef void (*_fn)();
 extern uint8_t curr_tcb_i;
 
 // mutex
-#define MAX_MUTEXES 1
-#define MAX_MUTEX_QUEUE_SIZE 2
+#define MAX_MUTEXES 16
+#define NO_MUTEX 0xFF
 #define resource 0
+#define NO_CEILING 0xFF
 
 // semaphore
 #define MAX_SEMAPHORES 3
-#define MAX_SEMAPHORE_QUEUE_SIZE 2
 #define keyPressed 0
 #define keyReleased 1
 #define flashReq 2
 
+// event group
+#define MAX_EVENT_GROUPS 4
+#define EVENT_ANY   0              // wait until any of the flags is set
+#define EVENT_ALL   1              // wait until all of the flags are set
+#define EVENT_CLEAR 2              // or'd with the above: clear the flags that ended the wait
+
+// reader-writer lock
+#define MAX_RWLOCKS 4
+
+// condition variable
+#define MAX_CONDITIONS 4
+#define NO_CONDITION 0xFF
+
+// message queue
+#define MAX_MSG_QUEUES 4
+#define MAIL_SIZE 4                // item size of a mailbox, one heap buffer address
+
+// task notification actions
+#define NOTIFY_INCREMENT 0         // add one to the notification word (counting semaphore)
+#define NOTIFY_SET_BITS  1         // or the value into the word (event flags)
+#define NOTIFY_OVERWRITE 2         // replace the word with the value (one word mailbox)
+
 // tasks
+// the host build can raise MAX_TASKS (up to 255, NO_TASK is the last index) for the sim benchmarks
+#ifndef MAX_TASKS
 #define MAX_TASKS 12
+#endif
+#define NO_TASK 0xFF
+#define NO_LEVEL 0xFF
+
+// scheduling modes for the SCHED service call
+#define SCHED_RR   0
+#define SCHED_PRIO 1
+#define SCHED_EDF  2
 
 extern uint8_t taskCurrent;
 extern uint8_t taskCount;
 
+// wait queue of an object (semaphore, mutex), the tasks blocked on it in wakeup order
+// linked through tcb[].waitNext/waitPrev, a task waits on one object at a time
+#define WAIT_FIFO     0            // wake the longest waiting task first
+#define WAIT_PRIORITY 1            // wake the highest priority task first, fifo among equals
+#define WAIT_FOREVER  0xFFFFFFFF   // timeout of a blocking call that never gives up
+
+typedef struct _waitQueue
+{
+    uint8_t head;                  // first task to wake (NO_TASK if empty)
+    uint8_t tail;                  // last task to wake
+    uint8_t size;                  // number of waiting tasks
+    uint8_t order;                 // WAIT_FIFO or WAIT_PRIORITY
+} waitQueue;
+
 struct _tcb
 {
     uint8_t state;                 // see STATE_ values above
@@ -52,14 +98,43 @@ struct _tcb
     //uint32_t base_add;
     uint8_t priority;              // 0=highest
     uint8_t currentPriority;       // 0=highest (needed for pi)
-    uint32_t ticks;                // ticks until sleep complete
+    uint32_t ticks;                // ticks after the previous sleeper wakes (delta queue)
     uint64_t srd;                  // MPU subregion disable bits
     uint32_t req_size;
     uint32_t timeA;
     uint32_t timeB;
     char name[16];                 // name of task used in ps command
-    uint8_t mutex;                 // index of the mutex in use or blocking the thread
+    uint8_t mutex;                 // index of the mutex blocking the thread or relocked after condWait (NO_MUTEX if none)
+    uint8_t mutexHeld;             // first mutex the thread owns, the rest are linked through the mutexes
     uint8_t semaphore;             // index of the semaphore that is blocking the thread
+    uint8_t condition;             // condition variable waited on, kept until the mutex is relocked (NO_CONDITION if none)
+    uint8_t rwLock;                // index of the reader-writer lock blocking the thread
+    uint8_t readHeld;              // bit n set while the thread holds a read lock on reader-writer lock n
+    uint8_t event;                 // index of the event group blocking the thread
+    uint8_t eventMode;             // EVENT_ANY or EVENT_ALL, optionally EVENT_CLEAR
+    uint32_t eventFlags;           // flags the thread waits for
+    uint8_t msgQueue;              // index of the message queue blocking the thread
+    void *message;                 // item a blocked sender sends or a blocked receiver receives into
+    uint32_t notifyValue;          // notification word, the task has been notified while it is nonzero
+    bool notifyClear;              // takeNotify clears the word (true) or decrements it (false)
+    uint8_t readyNext;             // next task in the ready queue of readyLevel
+    uint8_t readyPrev;             // previous task in the ready queue of readyLevel
+    uint8_t readyLevel;            // ready queue the task is linked on (NO_LEVEL if not ready)
+    uint8_t sleepNext;             // next task in the sleep delta queue
+    uint8_t sleepPrev;             // previous task in the sleep delta queue
+    uint8_t waitNext;              // next task in the wait queue of the blocking object
+    uint8_t waitPrev;              // previous task in the wait queue of the blocking object
+    uint32_t deadline;             // relative deadline in ticks for edf (0 = none)
+    uint32_t absDeadline;          // tick time the current job is due
+    uint32_t period;               // release period in ticks for waitNextPeriod (0 = not periodic)
+    uint32_t nextRelease;          // tick time of the current release
+    uint32_t overruns;             // releases missed or started late
+    uint32_t quantum;              // time slice in ticks (0 = slice of the priority)
+    uint32_t sliceLeft;            // ticks left in the current time slice
+    uint32_t budget;               // cpu cycles allowed per budget period (0 = unlimited)
+    uint32_t budgetUsed;           // cycles used in the current budget period
+    uint32_t budgetPeriod;         // replenishment period in ticks
+    uint32_t budgetNext;           // tick time of the next replenishment
 } tcb[MAX_TASKS];
 
 struct _tcb tcb[MAX_TASKS];
@@ -68,27 +143,118 @@ struct _tcb tcb[MAX_TASKS];
 //-----------------------------------------------------------------------------
 
 bool initMutex(uint8_t mutex);
+bool initMutexCeiling(uint8_t mutex, uint8_t ceiling);
+bool initMutexOrder(uint8_t mutex, uint8_t ceiling, uint8_t order);
+uint8_t mutexPriority(uint8_t task);
+void priorityUpdate(uint8_t task);
+void mutexAcquire(uint8_t mutex, uint8_t task);
+void mutexRelease(uint8_t mutex);
 bool initSemaphore(uint8_t semaphore, uint8_t count);
+bool initSemaphoreOrder(uint8_t semaphore, uint8_t count, uint8_t order);
+bool initEventGroup(uint8_t group);
+bool initRwLock(uint8_t rwLock, bool writerPreference);
+bool initCondition(uint8_t condition);
+bool initConditionOrder(uint8_t condition, uint8_t order);
+bool initMsgQueue(uint8_t queue, uint8_t depth, uint8_t itemSize);
+bool initMailbox(uint8_t queue, uint8_t depth);
 
 void initRtos(void);
 void initWTimer(void);
 void startRtos(void);
 
 bool createThread(_fn fn, const char name[], uint8_t priority, uint32_t stackBytes);
+bool createThreadDeadline(_fn fn, const char name[], uint8_t priority, uint32_t stackBytes, uint32_t deadline);
+bool createThreadPeriodic(_fn fn, const char name[], uint8_t priority, uint32_t stackBytes, uint32_t period);
+bool createThreadTimed(_fn fn, const char name[], uint8_t priority, uint32_t stackBytes, uint32_t period, uint32_t deadline);
 _fn getPid(void);
 void killThread(_fn fn);
 void killT(_fn fn);
 void restartThread(_fn fn);
 void setThreadPriority(_fn fn, uint8_t priority);
+void setThreadDeadline(_fn fn, uint32_t deadline);
+void setThreadQuantum(_fn fn, uint32_t ticks);
+void setThreadBudget(_fn fn, uint32_t us, uint32_t period);
+void setPriorityQuantum(uint8_t priority, uint32_t ticks);
 
 void yield(void);
 void sleep(uint32_t tick);
+void waitNextPeriod(void);
 void wait(int8_t semaphore);
+bool waitTimeout(int8_t semaphore, uint32_t ticks);
 void post(int8_t semaphore);
 void lock(int8_t mutex);
+bool lockTimeout(int8_t mutex, uint32_t ticks);
 void unlock(int8_t mutex);
+void readLock(uint8_t rwLock);
+void readUnlock(uint8_t rwLock);
+void writeLock(uint8_t rwLock);
+void writeUnlock(uint8_t rwLock);
+bool condWait(uint8_t condition, int8_t mutex, uint32_t ticks);
+void condSignal(uint8_t condition);
+void condBroadcast(uint8_t condition);
+void setEvents(uint8_t group, uint32_t flags);
+void clearEvents(uint8_t group, uint32_t flags);
+uint32_t waitEvents(uint8_t group, uint32_t flags, uint8_t mode, uint32_t ticks);
+void postFromIsr(int8_t semaphore);
+void setEventsFromIsr(uint8_t group, uint32_t flags);
+void clearEventsFromIsr(uint8_t group, uint32_t flags);
+bool sendMessageFromIsr(uint8_t queue, const void *item);
+void notifyFromIsr(_fn fn, uint32_t value, uint8_t action);
+bool sendMessage(uint8_t queue, const void *item, uint32_t ticks);
+bool receiveMessage(uint8_t queue, void *item, uint32_t ticks);
+bool trySendMessage(uint8_t queue, const void *item);
+bool tryReceiveMessage(uint8_t queue, void *item);
+bool sendWord(uint8_t queue, uint32_t word, uint32_t ticks);
+void * allocMail(uint32_t size);
+void freeMail(void *buffer);
+bool sendMail(uint8_t queue, void *buffer, uint32_t ticks);
+bool receiveMail(uint8_t queue, void **buffer, uint32_t ticks);
+void notify(_fn fn, uint32_t value, uint8_t action);
+uint32_t takeNotify(bool clear, uint32_t ticks);
 void restart(uint8_t task);
 
+void readyInsert(uint8_t task);
+void readyRelease(uint8_t task);
+void readyRemove(uint8_t task);
+void readyRequeue(uint8_t task);
+void readyRebuild(void);
+void readyRotate(uint8_t task);
+bool readyOnly(uint8_t task);
+void sleepInsert(uint8_t task, uint32_t ticks);
+void sleepRemove(uint8_t task);
+uint32_t sleepRemaining(uint8_t task);
+void waitInit(waitQueue *queue, uint8_t order);
+void waitEnqueue(waitQueue *queue, uint8_t task);
+uint8_t waitDequeue(waitQueue *queue);
+void waitRemove(waitQueue *queue, uint8_t task);
+waitQueue *waitQueueOf(uint8_t task);
+void waitRequeue(uint8_t task);
+void waitGranted(uint8_t task, uint32_t result);
+bool waitExpire(uint8_t task);
+uint8_t rtosScheduler(void);
+void reschedule(void);
+bool eventMatch(uint32_t flags, uint32_t wanted, uint8_t mode);
+void eventSet(uint8_t group, uint32_t flags);
+void semaphorePost(uint8_t semaphore);
+void notifyPid(void *pid, uint32_t value, uint8_t action);
+uint32_t notifyTake(uint8_t task);
+uint8_t rwPriority(uint8_t task, uint8_t prio);
+void rwUpdateHolders(uint8_t rwLock);
+bool rwReadAdmit(uint8_t rwLock, uint8_t prio);
+void rwAdmit(uint8_t rwLock);
+void rwRelease(uint8_t rwLock, uint8_t task);
+bool condRelock(uint8_t task);
+void condWake(uint8_t condition, bool all);
+void notifyTask(uint8_t task, uint32_t value, uint8_t action);
+void msgCopy(void *dest, const void *source, uint8_t size);
+bool msgSend(uint8_t queue, const void *item);
+bool msgReceive(uint8_t queue, void *item);
+void mailTake(uint8_t task, const void *item);
+void mailGive(uint8_t task, const void *item);
+
+void ticklessSync(void);
+void ticklessProgram(void);
+
 void systickIsr(void);
 void pendSvIsr(void);
 void svCallIsr(void);
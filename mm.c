@@ -223,6 +223,43 @@ void freeHeap(void *address_from_malloc)
 
 }
 
+// hand every block of an allocation to another owner
+// kernel objects use owner NO_TASK and a NULL pid so no task kill frees them
+void setHeapOwner(void *address_from_malloc, uint8_t owner, void *pid)
+{
+    if(address_from_malloc < (void*)HEAP_START || address_from_malloc >= (void*)(HEAP_START + (TOTAL_BLOCKS * BLOCK_SIZE)))
+        return;
+    uint32_t index = ((uint32_t)address_from_malloc - HEAP_START) / BLOCK_SIZE;
+    uint32_t i = 0;
+    if (!heap_map[index].is_allocated || heap_map[index].blocks_allocated == 0)
+        return;
+    for(i = 0; i < heap_map[index].blocks_allocated; i++)
+    {
+        heap_map[index + i].owner = owner;
+        heap_map[index + i].pid = pid;
+    }
+}
+
+// pid owning the allocation that starts at address_from_malloc (NULL if none starts there)
+void * getHeapOwner(void *address_from_malloc)
+{
+    if(address_from_malloc < (void*)HEAP_START || address_from_malloc >= (void*)(HEAP_START + (TOTAL_BLOCKS * BLOCK_SIZE)))
+        return NULL;
+    uint32_t offset = (uint32_t)address_from_malloc - HEAP_START;
+    uint32_t index = offset / BLOCK_SIZE;
+    if((offset % BLOCK_SIZE) != 0 || !heap_map[index].is_allocated || heap_map[index].blocks_allocated == 0)
+        return NULL;
+    return heap_map[index].pid;
+}
+
+// bytes requested for the allocation that starts at address_from_malloc
+uint32_t getHeapSize(void *address_from_malloc)
+{
+    if(address_from_malloc < (void*)HEAP_START || address_from_malloc >= (void*)(HEAP_START + (TOTAL_BLOCKS * BLOCK_SIZE)))
+        return 0;
+    return heap_map[((uint32_t)address_from_malloc - HEAP_START) / BLOCK_SIZE].req_size;
+}
+
 void freeHeapPid(void * pid)
 {
     uint32_t i = 0;
@@ -39,6 +39,9 @@ void remSramAccessWindow(uint64_t *srdBitMask, uint32_t* baseAdd, uint32_t size_
 void * mallocHeap(uint32_t size_in_bytes);
 void freeHeap(void *address_from_malloc);
 void freeHeapPid(void * pid);
+void setHeapOwner(void *address_from_malloc, uint8_t owner, void *pid);
+void * getHeapOwner(void *address_from_malloc);
+uint32_t getHeapSize(void *address_from_malloc);
 void turnOnMPU(void);
 void allowFlashAccess(void);
 void allowPeripheralAccess(void);
@@ -0,0 +1,86 @@
+// Port layer functions for the TM4C123
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "port.h"
+
+#ifndef HOST_SIM
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// svc and systick at the kernel priority, pendsv below every handler (see PORT_KERNEL_PRIORITY)
+void portPrioritiesInit(void)
+{
+    NVIC_SYS_PRI2_R = (NVIC_SYS_PRI2_R & ~NVIC_SYS_PRI2_SVC_M) | (PORT_KERNEL_PRIORITY << NVIC_SYS_PRI2_SVC_S);
+    NVIC_SYS_PRI3_R = (NVIC_SYS_PRI3_R & ~(NVIC_SYS_PRI3_TICK_M | NVIC_SYS_PRI3_PENDSV_M))
+                    | (PORT_KERNEL_PRIORITY << NVIC_SYS_PRI3_TICK_S) | (PORT_LOWEST_PRIORITY << NVIC_SYS_PRI3_PENDSV_S);
+}
+
+// WTIMER0 A measures task run time, systick runs the kernel tick
+void portTimersInit(uint32_t tickReload)
+{
+    SYSCTL_RCGCWTIMER_R |= SYSCTL_RCGCWTIMER_R0;        //WTimer 0 clock
+    _delay_cycles(3);
+    WTIMER0_CTL_R &= ~TIMER_CTL_TAEN;   //timer off for configuration
+    WTIMER0_CFG_R = TIMER_CFG_32_BIT_TIMER;
+    WTIMER0_TAMR_R = TIMER_TAMR_TAMR_1_SHOT | TIMER_TAMR_TACDIR;
+    WTIMER0_TAILR_R = 40000000;
+    WTIMER0_TAV_R = 0;
+    WTIMER0_CTL_R |= TIMER_CTL_TAEN;
+
+    NVIC_ST_CTRL_R = 0;             //turn off for configuration
+    NVIC_ST_RELOAD_R = tickReload;
+    NVIC_ST_CURRENT_R = 0;
+    NVIC_ST_CTRL_R |= NVIC_ST_CTRL_CLK_SRC | NVIC_ST_CTRL_INTEN | NVIC_ST_CTRL_ENABLE;  //use sys clock and enable interrupt
+}
+
+// free running WTIMER0 B as the trace time base
+void portTraceTimerInit(void)
+{
+    WTIMER0_CTL_R &= ~TIMER_CTL_TBEN;
+    WTIMER0_TBMR_R = TIMER_TBMR_TBMR_PERIOD | TIMER_TBMR_TBCDIR;
+    WTIMER0_TBILR_R = 0xFFFFFFFF;
+    WTIMER0_TBV_R = 0;
+    WTIMER0_CTL_R |= TIMER_CTL_TBEN;
+}
+
+// build the frame popRegs and the exception return unstack for a task that never ran
+// returns the new stack pointer
+void *portStackInit(void *top, void (*fn)())
+{
+    uint32_t * sp = (uint32_t *)top;
+    sp -= 17;
+    sp[0] = 0xFFFFFFFD;                         //LR Exception Result   lowest mem address
+    sp[1] = 111;                                //R4
+    sp[2] = 110;
+    sp[3] = 109;
+    sp[4] = 108;
+    sp[5] = 107;
+    sp[6] = 106;
+    sp[7] = 105;
+    sp[8] = 104;                                //R11
+    sp[9] = 100;                                //R0
+    sp[10] = 101;
+    sp[11] = 102;
+    sp[12] = 103;                               //R3
+    sp[13] = 112;                               //R12
+    sp[14] = 0x11111111;                        //LR
+    sp[15] = (uint32_t)fn;                      //PC
+    sp[16] = 0x01000000;                        //xPSR      highest mem address
+    return (void*)sp;
+}
+
+#endif
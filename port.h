@@ -0,0 +1,157 @@
+// Port layer
+// Everything the kernel needs from the core and the timers
+//
+// The TM4C123 port maps straight onto the NVIC, SysTick, WTIMER0 and the
+// context switch helpers in asm.s. Building with HOST_SIM selects the Linux
+// port in host/port_host.c instead, so kernel.c, mm.c and trace.c can run as
+// a native process (see host/sim.c).
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+#ifndef PORT_H_
+#define PORT_H_
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tm4c123gh6pm.h"
+#include "asm.h"
+
+#define PORT_STR(x) #x
+
+// interrupt priorities, 0 highest to 7 lowest (the top 3 bits of each priority byte)
+// svc and systick run at the kernel priority and pendsv at the lowest, so a task switch
+// never runs on top of another handler. Handlers that call the FromIsr functions must run
+// at the kernel priority or below, a handler at 0 is never held off by the kernel but must not call it
+#define PORT_KERNEL_PRIORITY          1
+#define PORT_LOWEST_PRIORITY          7
+#define PORT_KERNEL_BASEPRI           (PORT_KERNEL_PRIORITY << 5)
+
+// kernel critical section for handler mode, holds off systick, pendsv and the handlers allowed to call
+// the kernel, returns the mask to restore
+#define PORT_ENTER_CRITICAL()         setBasepri(PORT_KERNEL_BASEPRI)
+#define PORT_EXIT_CRITICAL(mask)      setBasepri(mask)
+
+#ifndef HOST_SIM
+
+// service call stubs, the arguments are already in R0-R3 when the stub is entered
+// stubs returning a value leave it in R0 (stacked R0 written by svCallIsr)
+#define PORT_SVC0(n)                  __asm(" SVC #" PORT_STR(n))
+#define PORT_SVC1(n, a)               PORT_SVC0(n)
+#define PORT_SVC2(n, a, b)            PORT_SVC0(n)
+#define PORT_SVC3(n, a, b, c)         PORT_SVC0(n)
+#define PORT_SVC_RET1(n, type, a)     PORT_SVC0(n)
+#define PORT_SVC_RET2(n, type, a, b)  PORT_SVC0(n)
+#define PORT_SVC_RET3(n, type, a, b, c) PORT_SVC0(n)
+#define PORT_SVC_RET4(n, type, a, b, c, d) PORT_SVC0(n)
+
+// return value of the service call a switched out task is blocked in
+// sp is its saved stack pointer, stacked R0 sits above LR and R4-R11 (see portStackInit)
+#define PORT_SET_RESULT(sp, value)    (((uint32_t*)(sp))[9] = (value))
+
+// same for the running task blocked in an svc whose switch is still pending when a handler wakes it,
+// its frame is the one on the process stack
+#define PORT_SET_RESULT_CURRENT(value) (getPSP()[0] = (value))
+
+// handlers that manage the stack themselves
+#define PORT_NAKED                    __attribute__((naked))
+
+// memory barrier, stores before it are visible to an interrupt handler before stores after it
+#define PORT_BARRIER()                __asm(" DMB")
+
+// task switch and reset requests
+#define PORT_PEND_SWITCH()            (NVIC_INT_CTRL_R |= NVIC_INT_CTRL_PEND_SV)
+#define PORT_RESET()                  (NVIC_APINT_R = (NVIC_APINT_VECTKEY | 4))
+
+// run timer (WTIMER0 A), counts the cycles of the running task
+#define PORT_RUN_TIME()               (WTIMER0_TAV_R)
+#define PORT_RUN_STOP()               (WTIMER0_CTL_R &= ~TIMER_CTL_TAEN)
+#define PORT_RUN_RESTART()            do { WTIMER0_TAV_R = 0; WTIMER0_CTL_R |= TIMER_CTL_TAEN; } while(0)
+
+// systick, reload and current value in cycles
+#define PORT_TICK_RELOAD()            (NVIC_ST_RELOAD_R)
+#define PORT_TICK_CURRENT()           (NVIC_ST_CURRENT_R)
+#define PORT_TICK_WRAPPED()           (NVIC_ST_CTRL_R & NVIC_ST_CTRL_COUNT)
+#define PORT_TICK_CLEAR_PENDING()     (NVIC_INT_CTRL_R = NVIC_INT_CTRL_PENDSTCLR)
+#define PORT_TICK_SET(reload)         do { NVIC_ST_RELOAD_R = (reload); NVIC_ST_CURRENT_R = 0; } while(0)
+
+// trace time base (WTIMER0 B)
+#define PORT_TRACE_TIME()             (WTIMER0_TBV_R)
+
+// run the first task on its own stack in unprivileged thread mode
+#define PORT_START(sp, fn)            do { setPSP(sp); setASP(); setTMPL(1); (fn)(); } while(0)
+
+#else
+
+// Linux host simulation
+// build 64-bit with -DHOST_SIM -no-pie so code, data and the task stacks
+// stay below 4 GiB where the kernel's 32-bit register images can hold them
+
+#define _delay_cycles(n)
+
+uint32_t portSvc(uint8_t n, uint32_t r0, uint32_t r1, uint32_t r2, uint32_t r3);
+
+#define PORT_ARG(a)                   ((uint32_t)(uintptr_t)(a))
+#define PORT_SVC0(n)                  portSvc(n, 0, 0, 0, 0)
+#define PORT_SVC1(n, a)               portSvc(n, PORT_ARG(a), 0, 0, 0)
+#define PORT_SVC2(n, a, b)            portSvc(n, PORT_ARG(a), PORT_ARG(b), 0, 0)
+#define PORT_SVC3(n, a, b, c)         portSvc(n, PORT_ARG(a), PORT_ARG(b), PORT_ARG(c), 0)
+#define PORT_SVC_RET1(n, type, a)     return (type)(uintptr_t)portSvc(n, PORT_ARG(a), 0, 0, 0)
+#define PORT_SVC_RET2(n, type, a, b)  return (type)(uintptr_t)portSvc(n, PORT_ARG(a), PORT_ARG(b), 0, 0)
+#define PORT_SVC_RET3(n, type, a, b, c) return (type)(uintptr_t)portSvc(n, PORT_ARG(a), PORT_ARG(b), PORT_ARG(c), 0)
+#define PORT_SVC_RET4(n, type, a, b, c, d) return (type)(uintptr_t)portSvc(n, PORT_ARG(a), PORT_ARG(b), PORT_ARG(c), PORT_ARG(d))
+
+#define PORT_NAKED
+#define PORT_BARRIER()                __sync_synchronize()
+
+extern volatile bool portSwitchPending;
+void portReset(void);
+uint32_t portCycles(void);
+uint32_t portRunTime(void);
+void portRunRestart(void);
+uint32_t portTickReload(void);
+uint32_t portTickCurrent(void);
+bool portTickWrapped(void);
+void portTickClearPending(void);
+void portTickSet(uint32_t reload);
+void portStart(void *sp, void (*fn)());
+void portSetResult(void *sp, uint32_t value);
+void portSetResultCurrent(uint32_t value);
+
+#define PORT_PEND_SWITCH()            (portSwitchPending = true)
+#define PORT_RESET()                  portReset()
+#define PORT_RUN_TIME()               portRunTime()
+#define PORT_RUN_STOP()
+#define PORT_RUN_RESTART()            portRunRestart()
+#define PORT_TICK_RELOAD()            portTickReload()
+#define PORT_TICK_CURRENT()           portTickCurrent()
+#define PORT_TICK_WRAPPED()           portTickWrapped()
+#define PORT_TICK_CLEAR_PENDING()     portTickClearPending()
+#define PORT_TICK_SET(reload)         portTickSet(reload)
+#define PORT_TRACE_TIME()             portCycles()
+#define PORT_START(sp, fn)            portStart(sp, fn)
+#define PORT_SET_RESULT(sp, value)    portSetResult(sp, value)
+#define PORT_SET_RESULT_CURRENT(value) portSetResultCurrent(value)
+
+void portInit(void);
+
+#endif
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void portPrioritiesInit(void);
+void portTimersInit(uint32_t tickReload);
+void portTraceTimerInit(void);
+void *portStackInit(void *sp, void (*fn)());
+
+#endif
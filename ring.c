@@ -0,0 +1,141 @@
+// Single producer, single consumer ring buffers
+//
+// Lets an interrupt handler pass a byte stream to a task without a service
+// call, which handler mode cannot make. Each index is stored by one side
+// only, so neither side ever locks: the producer fills bytes and then
+// publishes them by advancing head, the consumer copies bytes out and then
+// frees them by advancing tail. The barriers keep the data accesses on the
+// right side of those stores.
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "port.h"
+#include "kernel.h"
+#include "ring.h"
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// buffer holds size bytes, size a power of 2
+// the ring and its buffer must lie in memory the consumer task may access (its stack or allocMail())
+bool initRing(RING_BUFFER *ring, void *buffer, uint32_t size)
+{
+    bool ok = (buffer != NULL && size != 0 && (size & (size - 1)) == 0);
+    if(ok)
+    {
+        ring->buffer = buffer;
+        ring->size = size;
+        ring->head = 0;
+        ring->tail = 0;
+        ring->group = RING_NO_EVENT;
+        ring->flags = 0;
+    }
+    return ok;
+}
+
+// set flags in event group when the ring goes from empty to non-empty
+// the producer must then be an interrupt handler (see setEventsFromIsr)
+void ringNotify(RING_BUFFER *ring, int8_t group, uint32_t flags)
+{
+    ring->group = group;
+    ring->flags = flags;
+}
+
+uint32_t ringCount(const RING_BUFFER *ring)
+{
+    return ring->head - ring->tail;
+}
+
+uint32_t ringSpace(const RING_BUFFER *ring)
+{
+    return ring->size - (ring->head - ring->tail);
+}
+
+// producer side
+// copies up to length bytes into the ring, returns the number copied (less when it fills up)
+uint32_t ringWrite(RING_BUFFER *ring, const void *data, uint32_t length)
+{
+    const uint8_t *src = data;
+    uint32_t head = ring->head;
+    uint32_t tail = ring->tail;
+    uint32_t mask = ring->size - 1;
+    uint32_t i;
+    if(length > ring->size - (head - tail))
+        length = ring->size - (head - tail);
+    if(length == 0)
+        return 0;
+    PORT_BARRIER();                     //the consumer is done reading the bytes tail freed before they are overwritten
+    for(i = 0; i < length; i++)
+        ring->buffer[(head + i) & mask] = src[i];
+    PORT_BARRIER();                     //the bytes are in place before head publishes them
+    ring->head = head + length;
+    if(ring->group != RING_NO_EVENT)
+    {
+        PORT_BARRIER();                 //head is stored before tail is read again (see ringReadWait)
+        if(ring->tail == head)          //the consumer may have emptied the ring since tail was read above
+            setEventsFromIsr(ring->group, ring->flags);
+    }
+    return length;
+}
+
+bool ringPut(RING_BUFFER *ring, uint8_t data)
+{
+    return ringWrite(ring, &data, 1) == 1;
+}
+
+// consumer side
+// copies up to length bytes out of the ring, returns the number copied (0 if it is empty)
+uint32_t ringRead(RING_BUFFER *ring, void *data, uint32_t length)
+{
+    uint8_t *dst = data;
+    uint32_t tail = ring->tail;
+    uint32_t head = ring->head;
+    uint32_t mask = ring->size - 1;
+    uint32_t i;
+    if(length > head - tail)
+        length = head - tail;
+    if(length == 0)
+        return 0;
+    PORT_BARRIER();                     //read the bytes head published, not older contents
+    for(i = 0; i < length; i++)
+        dst[i] = ring->buffer[(tail + i) & mask];
+    PORT_BARRIER();                     //the bytes are copied out before tail hands their slots back
+    ring->tail = tail + length;
+    return length;
+}
+
+bool ringGet(RING_BUFFER *ring, uint8_t *data)
+{
+    return ringRead(ring, data, 1) == 1;
+}
+
+// like ringRead, but blocks in waitEvents up to ticks while the ring is empty
+// needs ringNotify, returns 0 on timeout
+// a write the consumer does not see either finds tail at its old head and sets the flags,
+// or was published before the consumer read head, so no write between the check and the wait is lost
+uint32_t ringReadWait(RING_BUFFER *ring, void *data, uint32_t length, uint32_t ticks)
+{
+    uint32_t n;
+    PORT_BARRIER();                     //tail stored by the last ringRead before head is read
+    n = ringRead(ring, data, length);
+    while(n == 0 && length != 0 && ring->group != RING_NO_EVENT)
+    {
+        if(waitEvents(ring->group, ring->flags, EVENT_ANY | EVENT_CLEAR, ticks) == 0)
+            break;
+        n = ringRead(ring, data, length);
+    }
+    return n;
+}
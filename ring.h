@@ -0,0 +1,49 @@
+// Single producer, single consumer ring buffers
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+#ifndef RING_H_
+#define RING_H_
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define RING_NO_EVENT -1               // group of a ring that wakes nobody
+
+// byte ring shared by one producer (usually an interrupt handler) and one consumer task
+// head and tail count bytes from the start and are masked with size - 1 when indexed,
+// so full (head - tail == size) and empty (head == tail) need no spare slot
+typedef struct _RING_BUFFER
+{
+    volatile uint8_t *buffer;          // size bytes, readable and writable by the consumer task
+    uint32_t size;                     // power of 2
+    volatile uint32_t head;            // bytes written, only stored by the producer
+    volatile uint32_t tail;            // bytes read, only stored by the consumer
+    int8_t group;                      // event group set when the ring becomes non-empty (RING_NO_EVENT if none)
+    uint32_t flags;                    // flags set in group
+} RING_BUFFER;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+bool initRing(RING_BUFFER *ring, void *buffer, uint32_t size);
+void ringNotify(RING_BUFFER *ring, int8_t group, uint32_t flags);
+uint32_t ringCount(const RING_BUFFER *ring);
+uint32_t ringSpace(const RING_BUFFER *ring);
+bool ringPut(RING_BUFFER *ring, uint8_t data);
+bool ringGet(RING_BUFFER *ring, uint8_t *data);
+uint32_t ringWrite(RING_BUFFER *ring, const void *data, uint32_t length);
+uint32_t ringRead(RING_BUFFER *ring, void *data, uint32_t length);
+uint32_t ringReadWait(RING_BUFFER *ring, void *data, uint32_t length, uint32_t ticks);
+
+#endif
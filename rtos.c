@@ -63,14 +63,12 @@ int main(void)
 
     // Initialize mutexes and semaphores
     initMutex(resource);
-    initSemaphore(keyPressed, 1);
-    initSemaphore(keyReleased, 0);
     initSemaphore(flashReq, 5);
 
     // Add required idle process at lowest priority
     ok =  createThread(idle, "Idle", 7, 512);
     ok &= createThread(lengthyFn, "LengthyFn", 6, 1024);
-    ok &= createThread(flash4Hz, "Flash4Hz", 4, 512);
+    ok &= createThreadPeriodic(flash4Hz, "Flash4Hz", 4, 512, 125);
     ok &= createThread(oneshot, "OneShot", 2, 1024);
     ok &= createThread(readKeys, "ReadKeys", 6, 512);
     ok &= createThread(debounce, "Debounce", 6, 1024);
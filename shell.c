@@ -353,26 +353,88 @@ void shell(void)
                     putsUart0("Invalid field for preempt\n");
                 }
             }
+            else if (isCommand(&data, "tickless", 1))
+            {
+                char* str = getFieldString(&data, 1);
+                valid = true;
+                bool on = 0;
+                if(strcompare(str, "on") || strcompare(str, "ON"))
+                {
+                    on = 1;
+                    tickless(on);
+                }
+                else if(strcompare(str, "off") || strcompare(str, "OFF"))
+                {
+                    on = 0;
+                    tickless(on);
+                }
+                else
+                {
+                    putsUart0("Invalid field for tickless\n");
+                }
+            }
             else if (isCommand(&data, "sched", 1))
             {
                 char* str = getFieldString(&data, 1);
                 valid = true;
-                bool prio_on = 0;
                 if(strcompare(str, "prio") || strcompare(str, "PRIO"))
                 {
-                    prio_on = 1;
-                    sched(prio_on);
+                    sched(SCHED_PRIO);
                 }
                 else if(strcompare(str, "rr") || strcompare(str, "RR"))
                 {
-                    prio_on = 0;
-                    sched(prio_on);
+                    sched(SCHED_RR);
+                }
+                else if(strcompare(str, "edf") || strcompare(str, "EDF"))
+                {
+                    sched(SCHED_EDF);
                 }
                 else
                 {
                     putsUart0("Invalid field for sched\n");
                 }
             }
+            else if(isCommand(&data, "quantum", 2))
+            {
+                valid = true;
+                int32_t ms = getFieldInteger(&data, 2);
+                if(data.fieldType[1] == 'n')
+                {
+                    quantumPrio(getFieldInteger(&data, 1), ms);
+                }
+                else
+                {
+                    quantumTask(getFieldString(&data, 1), ms);
+                }
+            }
+            else if(isCommand(&data, "budget", 3))
+            {
+                valid = true;
+                budget(getFieldString(&data, 1), getFieldInteger(&data, 2), getFieldInteger(&data, 3));
+            }
+            else if(isCommand(&data, "trace", 1))
+            {
+                char* str = getFieldString(&data, 1);
+                valid = true;
+                if(strcompare(str, "start") || strcompare(str, "START"))
+                {
+                    traceCtl(TRACE_START, NULL);
+                    putsUart0("Trace started\n\n");
+                }
+                else if(strcompare(str, "stop") || strcompare(str, "STOP"))
+                {
+                    traceCtl(TRACE_STOP, NULL);
+                    putsUart0("Trace stopped\n\n");
+                }
+                else if(strcompare(str, "dump") || strcompare(str, "DUMP"))
+                {
+                    traceDump();
+                }
+                else
+                {
+                    putsUart0("Invalid field for trace\n");
+                }
+            }
             else if(isCommand(&data, "reboot", 0))
             {
                 valid = true;
@@ -388,8 +450,8 @@ void shell(void)
                 uint32_t integer = 0;
                 uint32_t fraction = 0;
 
-                putsUart0("\nPID \t\tName\t\tTicks\tState\t\t%CPU\n");
-                putsUart0("--------------------------------------------------------------------\n");
+                putsUart0("\nPID \t\tName\t\tTicks\tState\t\t%CPU\tDeadline\tOvr\n");
+                putsUart0("------------------------------------------------------------------------------------\n");
                 for(i = 0; i < 12; i++)
                 {
                     if(data.tasks[i].state != 0)   //check if task is valid
@@ -410,7 +472,7 @@ void shell(void)
 
                         intToString(data.tasks[i].ticks);
                         putsUart0(" ms\t");
-                        if(data.tasks[i].state == 4 || data.tasks[i].state == 5)
+                        if(data.tasks[i].state == 4 || data.tasks[i].state == 5 || data.tasks[i].state >= 7)
                         {
                             printState(data.tasks[i].state);
                             putsUart0("\t");
@@ -431,10 +493,30 @@ void shell(void)
                             putsUart0("0");
                         }
                         intToString(fraction);
-                        putsUart0("%\n");
+                        putsUart0("%\t");
+                        if(data.tasks[i].hasDeadline)
+                        {
+                            intToString(data.tasks[i].deadline);
+                            putsUart0(" ms\t");
+                        }
+                        else
+                        {
+                            putsUart0("-\t\t");
+                        }
+                        intToString(data.tasks[i].overruns);
+                        putsUart0("\n");
                     }
                 }
-                putsUart0("\n");
+                putsUart0("Time: ");
+                intToString(data.time);
+                putsUart0(" ms\n");
+                putsUart0("Switches: ");
+                intToString(data.switchRequested);
+                putsUart0(" requested, ");
+                intToString(data.switchUseful);
+                putsUart0(" useful, ");
+                intToString(data.switchAvoided);
+                putsUart0(" avoided\n\n");
             }
             else if(isCommand(&data, "ipcs", 0))
             {
@@ -443,29 +525,39 @@ void shell(void)
                 uint8_t i = 0;
                 ipcs(&data);
                 putsUart0("\nMutex Status\n");
-                putsUart0("State\tLockedBy  QSize  Queue\n");
-                putsUart0("----------------------------------------\n");
-                if(data.mutexes[0].lock)
+                putsUart0("Mutex\tState\t\tLockedBy\tCeil\tQSize\tQueue\n");
+                putsUart0("------------------------------------------------------------\n");
+                for(i = 0; i < MAX_MUTEXES; i++)
                 {
-                    putsUart0("Locked\t");
-                    putsUart0(data.mutexes[0].lockedBy);
-                    putsUart0(" ");
-                    if(data.mutexes[0].queueSize != 0)
+                    if(!data.mutexes[i].valid)
+                        continue;
+                    intToString(i);
+                    putsUart0("\t");
+                    if(data.mutexes[i].lock)
                     {
-                        intToString(data.mutexes[0].queueSize);
-                        putsUart0("\t ");
-                        putsUart0(data.mutexes[0].processQueue[0]);
+                        putsUart0("Locked\t\t");
+                        putsUart0(data.mutexes[i].lockedBy);
+                        putsUart0("\t");
                     }
                     else
                     {
-                        putsUart0("0");
+                        putsUart0("Unlocked\t-\t");
                     }
-                    putsUart0("\n\n");
-                }
-                else
-                {
-                    putsUart0("Unlocked");
+                    putsUart0("\t");
+                    if(data.mutexes[i].ceiling != NO_CEILING)
+                        intToString(data.mutexes[i].ceiling);
+                    else
+                        putsUart0("-");
+                    putsUart0("\t");
+                    intToString(data.mutexes[i].queueSize);
+                    if(data.mutexes[i].queueSize != 0)
+                    {
+                        putsUart0("\t");
+                        putsUart0(data.mutexes[i].processQueue);
+                    }
+                    putsUart0("\n");
                 }
+                putsUart0("\n");
 
                 //Semaphore Info
                 putsUart0("Semaphore Status\n");
@@ -481,7 +573,7 @@ void shell(void)
                     {
                         intToString(data.semaphores[i].queueSize);
                         putsUart0("\t");
-                        putsUart0(data.semaphores[i].processQueue[0]);
+                        putsUart0(data.semaphores[i].processQueue);
                     }
                     else
                     {
@@ -491,6 +583,97 @@ void shell(void)
                 }
                 putsUart0("\n");
 
+                //Message queue Info
+                putsUart0("Message Queue Status\n");
+                putsUart0("Queue\tDepth\tSize\tCount\tBuffer\t\tSend\tRecv\n");
+                putsUart0("------------------------------------------------------------\n");
+                for(i = 0; i < MAX_MSG_QUEUES; i++)
+                {
+                    if(!data.msgQueues[i].valid)
+                        continue;
+                    intToString(i);
+                    putsUart0("\t");
+                    intToString(data.msgQueues[i].depth);
+                    putsUart0("\t");
+                    if(data.msgQueues[i].mailbox)
+                        putsUart0("mail");
+                    else
+                        intToString(data.msgQueues[i].itemSize);
+                    putsUart0("\t");
+                    intToString(data.msgQueues[i].count);
+                    putsUart0("\t");
+                    intToHex(data.msgQueues[i].buffer);
+                    putsUart0("\t");
+                    intToString(data.msgQueues[i].senders);
+                    putsUart0("\t");
+                    intToString(data.msgQueues[i].receivers);
+                    putsUart0("\n");
+                }
+                putsUart0("\n");
+
+                //Event group Info
+                putsUart0("Event Group Status\n");
+                putsUart0("Group\tFlags\t\tQSize\tQueue\n");
+                putsUart0("----------------------------------------\n");
+                for(i = 0; i < MAX_EVENT_GROUPS; i++)
+                {
+                    if(!data.events[i].valid)
+                        continue;
+                    intToString(i);
+                    putsUart0("\t");
+                    intToHex(data.events[i].flags);
+                    putsUart0("\t");
+                    intToString(data.events[i].queueSize);
+                    if(data.events[i].queueSize != 0)
+                    {
+                        putsUart0("\t");
+                        putsUart0(data.events[i].processQueue);
+                    }
+                    putsUart0("\n");
+                }
+                putsUart0("\n");
+
+                //Reader-writer lock Info
+                putsUart0("Reader-Writer Lock Status\n");
+                putsUart0("Lock\tPrefer\tReaders\tRWait\tWWait\tWriter\n");
+                putsUart0("----------------------------------------------------\n");
+                for(i = 0; i < MAX_RWLOCKS; i++)
+                {
+                    if(!data.rwLocks[i].valid)
+                        continue;
+                    intToString(i);
+                    putsUart0(data.rwLocks[i].writerPreference ? "\twriter\t" : "\tprio\t");
+                    intToString(data.rwLocks[i].readers);
+                    putsUart0("\t");
+                    intToString(data.rwLocks[i].readWaiting);
+                    putsUart0("\t");
+                    intToString(data.rwLocks[i].writeWaiting);
+                    putsUart0("\t");
+                    putsUart0(data.rwLocks[i].writer);
+                    putsUart0("\n");
+                }
+                putsUart0("\n");
+
+                //Condition variable Info
+                putsUart0("Condition Variable Status\n");
+                putsUart0("Cond\tQSize\tQueue\n");
+                putsUart0("----------------------------------------\n");
+                for(i = 0; i < MAX_CONDITIONS; i++)
+                {
+                    if(!data.conditions[i].valid)
+                        continue;
+                    intToString(i);
+                    putsUart0("\t");
+                    intToString(data.conditions[i].queueSize);
+                    if(data.conditions[i].queueSize != 0)
+                    {
+                        putsUart0("\t");
+                        putsUart0(data.conditions[i].processQueue);
+                    }
+                    putsUart0("\n");
+                }
+                putsUart0("\n");
+
             }
             else if(isCommand(&data, "kill", 1))
             {
@@ -534,7 +717,11 @@ void shell(void)
                 putsUart0("pkill proc_name  Kills the thread based on the process name\n");
                 putsUart0("pi ON|OFF        Turns priority inheritance on or off\n");
                 putsUart0("preempt ON|OFF   Turns preemption on or off\n");
-                putsUart0("sched PRIO | RR  Selected priority or round-robin scheduling\n");
+                putsUart0("quantum task|prio ms  Sets the time slice of a task or a priority level\n");
+                putsUart0("budget task us ms  Limits a task to us of cpu time every ms (us = 0 removes it)\n");
+                putsUart0("trace START|STOP|DUMP  Records scheduler events or prints them for tools/trace_decode.py\n");
+                putsUart0("tickless ON|OFF  Programs the system timer for the next deadline instead of every 1 ms\n");
+                putsUart0("sched PRIO|RR|EDF Selects priority, round-robin or earliest deadline first scheduling\n");
                 putsUart0("pidof proc_name  Displays the PID of the process (thread)\n");
                 putsUart0("run proc_name    Runs the selected program in the background\n");
 
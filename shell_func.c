@@ -12,7 +12,7 @@
 #include "uart0.h"
 #include "shell.h"
 #include "shell_func.h"
-#include "tm4c123gh6pm.h"
+#include "port.h"
 
 #define RED_LED      (*((volatile uint32_t *)(0x42000000 + (0x400253FC-0x40000000)*32 + 1*4)))
 
@@ -41,6 +41,30 @@ void printState(uint8_t state)
     case 6:
         putsUart0("KILLED");
         break;
+    case 7:
+        putsUart0("THROTTLED");
+        break;
+    case 8:
+        putsUart0("BLOCKED(EVENT)");
+        break;
+    case 9:
+        putsUart0("BLOCKED(SEND)");
+        break;
+    case 10:
+        putsUart0("BLOCKED(RECV)");
+        break;
+    case 11:
+        putsUart0("BLOCKED(NOTIFY)");
+        break;
+    case 12:
+        putsUart0("BLOCKED(COND)");
+        break;
+    case 13:
+        putsUart0("BLOCKED(READ)");
+        break;
+    case 14:
+        putsUart0("BLOCKED(WRITE)");
+        break;
     default:
         putsUart0("UNKNOWN");
     }
@@ -48,29 +72,29 @@ void printState(uint8_t state)
 
 void ps(PS_INFO *data)
 {
-    __asm(" SVC #12");
+    PORT_SVC1(12, data);
 }
 
 void reboot()
 {
-    __asm(" SVC #9");
+    PORT_SVC0(9);
 }
 
 void ipcs(IPCS_INFO* data)
 {
-    __asm(" SVC #11");
+    PORT_SVC1(11, data);
 }
 
 void kill(uint32_t pid)
 {
-    __asm(" SVC #14");
+    PORT_SVC1(14, pid);
     putsUart0("Task killed");
     putcUart0('\n');
 }
 
 void pi(bool on)
 {
-    __asm(" SVC #6");
+    PORT_SVC1(6, on);
     if(on == 1)
     {
         putsUart0("Priority Inheritance ON");
@@ -83,14 +107,19 @@ void pi(bool on)
     }
 }
 
-void sched(bool prio_on)
+void sched(uint8_t mode)
 {
-    __asm(" SVC #7");
-    if(prio_on == 1)
+    PORT_SVC1(7, mode);
+    if(mode == SCHED_PRIO)
     {
         putsUart0("Priority Scheduling");
         putsUart0("\n\n");
     }
+    else if(mode == SCHED_EDF)
+    {
+        putsUart0("Earliest Deadline First Scheduling");
+        putsUart0("\n\n");
+    }
     else
     {
         putsUart0("Round Robin Scheduling");
@@ -100,7 +129,7 @@ void sched(bool prio_on)
 
 void preempt(bool on)
 {
-    __asm(" SVC #8");
+    PORT_SVC1(8, on);
     if(on == 1)
     {
         putsUart0("Preemption ON");
@@ -113,14 +142,127 @@ void preempt(bool on)
     }
 }
 
+void tickless(bool on)
+{
+    PORT_SVC1(18, on);
+    if(on == 1)
+    {
+        putsUart0("Tickless ON");
+        putsUart0("\n\n");
+    }
+    else
+    {
+        putsUart0("Tickless OFF");
+        putsUart0("\n\n");
+    }
+}
+
+void quantumTask(const char name[], uint32_t ms)
+{
+    _fn fn = (_fn)pidof(name);
+    if(fn != 0)
+    {
+        setThreadQuantum(fn, ms);
+        putsUart0((char*) name);
+        putsUart0(" quantum: ");
+        intToString(ms);
+        putsUart0(" ms\n\n");
+    }
+    else
+    {
+        putsUart0("Task not found\n\n");
+    }
+}
+
+void quantumPrio(uint8_t prio, uint32_t ms)
+{
+    if(prio < 8 && ms != 0)
+    {
+        setPriorityQuantum(prio, ms);
+        putsUart0("Priority ");
+        intToString(prio);
+        putsUart0(" quantum: ");
+        intToString(ms);
+        putsUart0(" ms\n\n");
+    }
+    else
+    {
+        putsUart0("Invalid priority or quantum\n\n");
+    }
+}
+
+void budget(const char name[], uint32_t us, uint32_t ms)
+{
+    _fn fn = (_fn)pidof(name);
+    if(fn != 0)
+    {
+        setThreadBudget(fn, us, ms);
+        putsUart0((char*) name);
+        putsUart0(" budget: ");
+        intToString(us);
+        putsUart0(" us every ");
+        intToString(ms);
+        putsUart0(" ms\n\n");
+    }
+    else
+    {
+        putsUart0("Task not found\n\n");
+    }
+}
+
+void traceCtl(uint8_t command, TRACE_INFO *info)
+{
+    PORT_SVC2(24, command, info);
+}
+
+// prints the trace ring as text for the host decoder (tools/trace_decode.py)
+// T lines map task indexes to names, E lines are time (WTIMER0 B), type, task and arg
+void traceDump(void)
+{
+    TRACE_INFO info;
+    PS_INFO tasks;
+    uint32_t i = 0;
+    traceCtl(TRACE_DUMP, &info);
+    ps(&tasks);
+    putsUart0("TRACE ");
+    intToString(info.count);
+    putsUart0(" ");
+    intToString(info.lost);
+    putsUart0("\n");
+    for(i = 0; i < MAX_TASKS; i++)
+    {
+        if(tasks.tasks[i].state != 0)
+        {
+            putsUart0("T ");
+            intToString(i);
+            putsUart0(" ");
+            putsUart0(tasks.tasks[i].name);
+            putsUart0("\n");
+        }
+    }
+    for(i = 0; i < info.count; i++)
+    {
+        putsUart0("E ");
+        intToHex(info.events[i].time);
+        putsUart0(" ");
+        intToString(info.events[i].type);
+        putsUart0(" ");
+        intToString(info.events[i].task);
+        putsUart0(" ");
+        intToString(info.events[i].arg);
+        putsUart0("\n");
+    }
+    putsUart0("END\n\n");
+}
+
 void* pidof(const char name[])
 {
-    __asm(" SVC #10");
+    PORT_SVC_RET1(10, void*, name);
 }
 
 void pkill(const char name[])
 {
-    __asm(" SVC #13");
+    PORT_SVC1(13, name);
     putsUart0("Task Killed: ");
     putsUart0((char*) name);
     putsUart0("\n\n");
@@ -128,7 +270,7 @@ void pkill(const char name[])
 
 void run_proc(const char name[])
 {
-    __asm(" SVC #15");
+    PORT_SVC1(15, name);
     putsUart0((char*) name);
     putsUart0(" Restarted");
     putsUart0("\n\n");
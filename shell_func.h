@@ -12,40 +12,91 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include "kernel.h"
+#include "trace.h"
 
 typedef struct _mutexINFO
 {
+    bool valid;             //initialized or in use
     bool lock;
     char lockedBy[16];      //name of task
-    char processQueue[MAX_MUTEX_QUEUE_SIZE][16];
+    char processQueue[16];  //name of the first waiting task
     uint8_t queueSize;
+    uint8_t ceiling;        //NO_CEILING if the mutex uses inheritance
 } MutexINFO;
 
 typedef struct _semINFO
 {
     uint8_t count;
-    char processQueue[MAX_SEMAPHORE_QUEUE_SIZE][16];
+    char processQueue[16];  //name of the first waiting task
     uint8_t queueSize;
 } SemINFO;
 
+typedef struct _eventINFO
+{
+    bool valid;             //initialized
+    uint32_t flags;
+    char processQueue[16];  //name of the first waiting task
+    uint8_t queueSize;
+} EventINFO;
+
+typedef struct _rwINFO
+{
+    bool valid;             //initialized
+    bool writerPreference;
+    uint8_t readers;        //tasks holding a read lock
+    char writer[16];        //name of the task holding the write lock
+    uint8_t readWaiting;    //tasks blocked in readLock
+    uint8_t writeWaiting;   //tasks blocked in writeLock
+} RwINFO;
+
+typedef struct _condINFO
+{
+    bool valid;             //initialized
+    char processQueue[16];  //name of the first waiting task
+    uint8_t queueSize;
+} CondINFO;
+
+typedef struct _queueINFO
+{
+    bool valid;             //initialized
+    uint8_t depth;
+    uint8_t itemSize;
+    bool mailbox;           //items are heap buffers passed by ownership
+    uint8_t count;          //items queued
+    uint32_t buffer;        //heap address of the ring
+    uint8_t senders;        //tasks blocked on a full queue
+    uint8_t receivers;      //tasks blocked on an empty queue
+} QueueINFO;
+
 typedef struct _ipcsINFO
 {
     MutexINFO mutexes[MAX_MUTEXES];
     SemINFO semaphores[MAX_SEMAPHORES];
+    EventINFO events[MAX_EVENT_GROUPS];
+    CondINFO conditions[MAX_CONDITIONS];
+    RwINFO rwLocks[MAX_RWLOCKS];
+    QueueINFO msgQueues[MAX_MSG_QUEUES];
 } IPCS_INFO;
 
 typedef struct _TaskInfo
 {
     void* pid;
     char name[16];
-    uint8_t ticks;
+    uint32_t ticks;
     uint8_t state;
     uint64_t cpu;
+    uint32_t deadline;      //absolute deadline of the current job (ms)
+    bool hasDeadline;
+    uint32_t overruns;      //missed or late periodic releases
 } TaskInfo;
 
 typedef struct _PS_INFO
 {
     TaskInfo tasks[MAX_TASKS];
+    uint32_t time;          //kernel time (ms)
+    uint32_t switchRequested;   //pendsv requests
+    uint32_t switchAvoided;     //requests skipped, running task still the best candidate
+    uint32_t switchUseful;      //dispatches that changed the running task
 } PS_INFO;
 
 void printState(uint8_t state);
@@ -55,7 +106,13 @@ void ipcs();
 void kill(uint32_t pid);
 void pi(bool on);
 void preempt(bool on);
-void sched(bool prio_on);
+void sched(uint8_t mode);
+void tickless(bool on);
+void quantumTask(const char name[], uint32_t ms);
+void quantumPrio(uint8_t prio, uint32_t ms);
+void budget(const char name[], uint32_t us, uint32_t ms);
+void traceCtl(uint8_t command, TRACE_INFO *info);
+void traceDump(void);
 void* pidof(const char name[]);
 void pkill(const char name[]);
 void run_proc(const char name[]);
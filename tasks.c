@@ -17,6 +17,7 @@
 #include "tm4c123gh6pm.h"
 #include "gpio.h"
 #include "wait.h"
+#include "port.h"
 #include "kernel.h"
 #include "tasks.h"
 
@@ -71,6 +72,18 @@ void initHw(void)
     enablePinPullup(SW5_BUTTON);
     enablePinPullup(SW6_BUTTON);
 
+    // SW0-SW5 interrupt on press, at the kernel priority since buttonIsr calls notifyFromIsr
+    // the pins stay masked until readKeys arms them, so no press can pend a switch before startRtos
+    selectPinInterruptFallingEdge(SW0_BUTTON);
+    selectPinInterruptFallingEdge(SW1_BUTTON);
+    selectPinInterruptFallingEdge(SW2_BUTTON);
+    selectPinInterruptFallingEdge(SW3_BUTTON);
+    selectPinInterruptFallingEdge(SW4_BUTTON);
+    selectPinInterruptFallingEdge(SW5_BUTTON);
+    NVIC_PRI0_R = (NVIC_PRI0_R & ~(NVIC_PRI0_INT2_M | NVIC_PRI0_INT3_M))
+                | (PORT_KERNEL_PRIORITY << NVIC_PRI0_INT2_S) | (PORT_KERNEL_PRIORITY << NVIC_PRI0_INT3_S);
+    NVIC_EN0_R = (1 << (INT_GPIOC-16)) | (1 << (INT_GPIOD-16));
+
     // Power-up flash
     setPinValue(GREEN_LED, 1);
     waitMicrosecond(250000);
@@ -97,6 +110,42 @@ uint8_t readPbs(void)
     return button;
 }
 
+// unmask (after dropping any stale edge) or mask the SW0-SW5 interrupts
+void armButtons(bool on)
+{
+    clearPinInterrupt(SW0_BUTTON);
+    clearPinInterrupt(SW1_BUTTON);
+    clearPinInterrupt(SW2_BUTTON);
+    clearPinInterrupt(SW3_BUTTON);
+    clearPinInterrupt(SW4_BUTTON);
+    clearPinInterrupt(SW5_BUTTON);
+    if(on)
+    {
+        enablePinInterrupt(SW0_BUTTON);
+        enablePinInterrupt(SW1_BUTTON);
+        enablePinInterrupt(SW2_BUTTON);
+        enablePinInterrupt(SW3_BUTTON);
+        enablePinInterrupt(SW4_BUTTON);
+        enablePinInterrupt(SW5_BUTTON);
+    }
+    else
+    {
+        disablePinInterrupt(SW0_BUTTON);
+        disablePinInterrupt(SW1_BUTTON);
+        disablePinInterrupt(SW2_BUTTON);
+        disablePinInterrupt(SW3_BUTTON);
+        disablePinInterrupt(SW4_BUTTON);
+        disablePinInterrupt(SW5_BUTTON);
+    }
+}
+
+// GPIO port C and D handler, masks the buttons until they are debounced and wakes readKeys
+void buttonIsr(void)
+{
+    armButtons(false);
+    notifyFromIsr(readKeys, 0, NOTIFY_INCREMENT);
+}
+
 // one task must be ready at all times or the scheduler will fail
 // the idle task is implemented for this purpose
 void idle(void)
@@ -128,7 +177,7 @@ void flash4Hz(void)
     while(true)
     {
         setPinValue(GREEN_LED, !getPinValue(GREEN_LED));
-        sleep(125);
+        waitNextPeriod();
     }
 }
 
@@ -175,16 +224,17 @@ void lengthyFn(void)
 void readKeys(void)
 {
     uint8_t buttons;
+    armButtons(true);
     while(true)
     {
-        wait(keyReleased);
-        buttons = 0;
-        while (buttons == 0)
+        takeNotify(true, WAIT_FOREVER);         //buttonIsr saw a press
+        buttons = readPbs();
+        if (buttons == 0)
         {
-            buttons = readPbs();
-            yield();
+            armButtons(true);                   //bounce, released again before readKeys ran
+            continue;
         }
-        post(keyPressed);
+        notify(debounce, 0, NOTIFY_INCREMENT);
         if ((buttons & 1) != 0)
         {
             setPinValue(YELLOW_LED, !getPinValue(YELLOW_LED));
@@ -216,7 +266,7 @@ void debounce(void)
     uint8_t count;
     while(true)
     {
-        wait(keyPressed);
+        takeNotify(true, WAIT_FOREVER);         //readKeys saw a button pressed
         count = 10;
         while (count != 0)
         {
@@ -226,7 +276,7 @@ void debounce(void)
             else
                 count = 10;
         }
-        post(keyReleased);
+        armButtons(true);                       //released, the next press interrupts again
     }
 }
 
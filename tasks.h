@@ -16,6 +16,8 @@
 //-----------------------------------------------------------------------------
 
 void initHw(void);
+void armButtons(bool on);
+void buttonIsr(void);
 
 void idle(void);
 void idle2(void);
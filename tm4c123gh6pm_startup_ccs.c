@@ -40,6 +40,7 @@ extern void usageFaultIsr(void);
 extern void pendSvIsr(void);
 extern void svCallIsr(void);
 extern void systickIsr(void);
+extern void buttonIsr(void);
 
 
 //*****************************************************************************
@@ -95,8 +96,8 @@ void (* const g_pfnVectors[])(void) =
     systickIsr,                             // The SysTick handler
     IntDefaultHandler,                      // GPIO Port A
     IntDefaultHandler,                      // GPIO Port B
-    IntDefaultHandler,                      // GPIO Port C
-    IntDefaultHandler,                      // GPIO Port D
+    buttonIsr,                              // GPIO Port C
+    buttonIsr,                              // GPIO Port D
     IntDefaultHandler,                      // GPIO Port E
     IntDefaultHandler,                      // UART0 Rx and Tx
     IntDefaultHandler,                      // UART1 Rx and Tx
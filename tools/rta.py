@@ -0,0 +1,240 @@
+#!/usr/bin/env python3
+# Response time analyzer
+#
+# Worst-case response times of the thread set in rtos.c under fixed priority
+# preemptive scheduling (priority 0 is highest), including blocking on
+# mutexes and the kernel's tick and context switch overheads.
+#
+#   python3 tools/rta.py rtos.c timing.txt [--trace log.txt] [--protocol pi|pcp|none]
+#
+# The thread set (name, priority, period and deadline) is read from the
+# createThread*() calls in rtos.c. The timing file adds what the source does
+# not say, one thread per line, times in ms:
+#
+#   # name     wcet   [period=]  [deadline=]  [jitter=]  [cs=mutex:ms,...]
+#   Flash4Hz   0.05
+#   Important  0.4    period=1000          cs=resource:0.3
+#   LengthyFn  20     period=1000          cs=resource:15
+#
+# period/deadline override the values from rtos.c. Threads without a
+# period (run forever or event driven) take no part unless one is given,
+# the period of an event driven thread is its minimum inter-arrival time.
+#
+# Kernel overheads in us: --switch-us (svc entry to dispatch), --tick-us
+# (systick handler) and --svc-us (one lock or unlock call). --trace takes a
+# `trace dump` log from the board and replaces each of them it can measure:
+#   switch  worst svc entry to switch time. Only a switch away from the task
+#           that made the svc, within --max-gap-us of it, counts as caused by
+#           it; a longer gap means the task ran on and the tick preempted it.
+#   svc     worst lock or unlock svc entry to its return event.
+#   tick    worst systick handler time (the trace keeps the ticks that woke
+#           or switched a task, which are the long ones).
+
+import argparse
+import math
+import re
+import sys
+
+CYCLES_PER_US = 40
+TICK_MS = 1.0
+
+CREATE = re.compile(r'createThread(\w*)\s*\(\s*(\w+)\s*,\s*"([^"]*)"\s*,\s*(\d+)\s*,\s*(\d+)\s*((?:,\s*\d+\s*)*)\)')
+
+
+class Task:
+    def __init__(self, name, prio):
+        self.name = name
+        self.prio = prio
+        self.wcet = None
+        self.period = None
+        self.deadline = None
+        self.jitter = 0.0
+        self.cs = {}                    # mutex -> longest critical section
+
+
+def read_threads(path):
+    tasks = []
+    with open(path) as f:
+        src = re.sub(r'//.*', '', f.read())
+    for kind, fn, name, prio, stack, extra in CREATE.findall(src):
+        t = Task(name, int(prio))
+        args = [int(a) for a in re.findall(r'\d+', extra)]
+        if kind == 'Deadline' and args:
+            t.deadline = args[0] or None
+        elif kind == 'Periodic' and args:
+            t.period = args[0]
+            t.deadline = args[0]
+        elif kind == 'Timed' and len(args) >= 2:
+            t.period = args[0] or None
+            t.deadline = args[1] or t.period
+        tasks.append(t)
+    return tasks
+
+
+def read_timing(path, tasks):
+    byname = {t.name: t for t in tasks}
+    with open(path) as f:
+        for n, line in enumerate(f, 1):
+            line = line.split('#')[0].split()
+            if not line:
+                continue
+            t = byname.get(line[0])
+            if t is None:
+                sys.exit('%s:%d: no thread named %s in rtos.c' % (path, n, line[0]))
+            t.wcet = float(line[1])
+            for field in line[2:]:
+                key, _, value = field.partition('=')
+                if key == 'period':
+                    t.period = float(value)
+                elif key == 'deadline':
+                    t.deadline = float(value)
+                elif key == 'jitter':
+                    t.jitter = float(value)
+                elif key == 'cs':
+                    for item in value.split(','):
+                        mutex, _, ms = item.partition(':')
+                        t.cs[mutex] = max(t.cs.get(mutex, 0.0), float(ms))
+                else:
+                    sys.exit('%s:%d: unknown field %s' % (path, n, key))
+
+
+# svc numbers of lock(), unlock() and lockTimeout() in kernel.c
+LOCK_SVCS = (2, 3, 26)
+
+
+def worst(a, b):
+    return b if a is None else max(a, b)
+
+
+# worst switch, lock svc and tick times in us in a trace dump (see tools/trace_decode.py)
+# each is None if the dump has no event pair for it
+def measured_costs(path, max_gap_us):
+    switch = svc = tick = None
+    last_svc = None                             # (time, task, svc number) of the latest svc
+    with open(path) as f:
+        for line in f:
+            e = line.split()
+            if len(e) < 5 or e[0] != 'E':
+                continue
+            time, kind, task, arg = int(e[1], 16), int(e[2]), int(e[3]), int(e[4])
+            if kind == 1:
+                last_svc = (time, task, arg)
+            elif kind == 5:
+                if last_svc is not None and last_svc[1:] == (task, arg) and arg in LOCK_SVCS:
+                    svc = worst(svc, ((time - last_svc[0]) & 0xFFFFFFFF) / CYCLES_PER_US)
+            elif kind == 4:
+                tick = worst(tick, arg / CYCLES_PER_US)
+            elif kind == 0:
+                # switch caused by that svc (wakes and blocks may sit between):
+                # away from the calling task and soon enough not to be a later tick
+                if last_svc is not None and arg == last_svc[1]:
+                    us = ((time - last_svc[0]) & 0xFFFFFFFF) / CYCLES_PER_US
+                    if us <= max_gap_us:
+                        switch = worst(switch, us)
+                last_svc = None
+    return switch, svc, tick
+
+
+def blocking(task, tasks, protocol):
+    lower = [t for t in tasks if t.prio > task.prio]
+    # ceiling of a mutex: highest priority of any thread using it
+    ceiling = {}
+    for t in tasks:
+        for m in t.cs:
+            ceiling[m] = min(ceiling.get(m, t.prio), t.prio)
+    # mutexes that can block task: used by a lower thread, ceiling at or above task
+    shared = [m for m in ceiling if ceiling[m] <= task.prio and any(m in t.cs for t in lower)]
+    if not shared:
+        return 0.0
+    if protocol == 'none':
+        return math.inf                 # medium priority threads can preempt the owner
+    if protocol == 'pcp':
+        return max(t.cs[m] for m in shared for t in lower if m in t.cs)
+    # priority inheritance: once per mutex and at most once per lower thread
+    per_mutex = sum(max(t.cs[m] for t in lower if m in t.cs) for m in shared)
+    per_task = sum(max((t.cs[m] for m in shared if m in t.cs), default=0.0) for t in lower)
+    return min(per_mutex, per_task)
+
+
+def response_time(task, tasks, b, switch, tick, svc):
+    # each preemption costs a switch in and out of the preempting thread,
+    # each critical section two service calls
+    own = task.wcet + 2 * switch + 2 * svc * len(task.cs)
+    higher = [t for t in tasks if t is not task and t.prio <= task.prio]
+    r = own + b
+    limit = task.deadline if task.deadline else task.period
+    while True:
+        n = own + b + math.ceil((r + task.jitter) / TICK_MS) * tick
+        for t in higher:
+            cost = t.wcet + 2 * switch + 2 * svc * len(t.cs)
+            n += math.ceil((r + t.jitter) / t.period) * cost
+        if n == r or n > 100 * limit:
+            return n
+        r = n
+
+
+def main():
+    p = argparse.ArgumentParser(description='response time analysis of the rtos.c thread set')
+    p.add_argument('rtos')
+    p.add_argument('timing')
+    p.add_argument('--trace', help='trace dump log used to measure the switch time')
+    p.add_argument('--protocol', choices=['pi', 'pcp', 'none'], default='pi')
+    p.add_argument('--switch-us', type=float, default=5.0)
+    p.add_argument('--tick-us', type=float, default=3.0)
+    p.add_argument('--svc-us', type=float, default=2.0)
+    p.add_argument('--max-gap-us', type=float, default=100.0,
+                   help='longest svc to switch time in the trace taken as one switch')
+    a = p.parse_args()
+
+    tasks = read_threads(a.rtos)
+    if not tasks:
+        sys.exit('no createThread calls in %s' % a.rtos)
+    read_timing(a.timing, tasks)
+
+    switch, svc, tick = a.switch_us, a.svc_us, a.tick_us
+    if a.trace:
+        m_switch, m_svc, m_tick = measured_costs(a.trace, a.max_gap_us)
+        if m_switch is None:
+            print('no svc to switch pairs in %s, using --switch-us' % a.trace)
+        else:
+            switch = m_switch
+        if m_svc is None:
+            print('no lock or unlock svc returns in %s, using --svc-us' % a.trace)
+        else:
+            svc = m_svc
+        if m_tick is None:
+            print('no systick events in %s, using --tick-us' % a.trace)
+        else:
+            tick = m_tick
+    switch, tick, svc = switch / 1000, tick / 1000, svc / 1000
+
+    # threads that recur with a known wcet take part in the analysis,
+    # any thread with critical sections can block them, periodic or not
+    active = [t for t in tasks if t.wcet is not None and t.period]
+    lockers = [t for t in tasks if t.cs]
+    for t in tasks:
+        if t not in active:
+            why = 'no wcet' if t.wcet is None else 'no period'
+            print('skipped %-12s (%s%s)' % (t.name, why, ', blocking only' if t.cs else ''))
+    active.sort(key=lambda t: t.prio)
+
+    u = sum(t.wcet / t.period for t in active) + tick / TICK_MS
+    print('switch %.1f us, tick %.1f us every %.0f ms, svc %.1f us, %s' %
+          (switch * 1000, tick * 1000, TICK_MS, svc * 1000, a.protocol))
+    print('utilization %.1f%%\n' % (100 * u))
+    print('%-12s %4s %9s %9s %9s %9s %9s  %s' % ('thread', 'prio', 'C', 'T', 'D', 'B', 'R', ''))
+    ok = True
+    for t in active:
+        d = t.deadline if t.deadline else t.period
+        b = blocking(t, active + [l for l in lockers if l not in active], a.protocol)
+        r = response_time(t, active, b, switch, tick, svc) if b != math.inf else math.inf
+        meets = r <= d
+        ok &= meets
+        print('%-12s %4d %9.3f %9.3f %9.3f %9.3f %9.3f  %s' %
+              (t.name, t.prio, t.wcet, t.period, d, b, r, 'ok' if meets else 'MISS'))
+    print('\nschedulable' if ok else '\nNOT schedulable')
+    sys.exit(0 if ok else 1)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+# Trace decoder
+#
+# Turns the output of the shell `trace dump` command into a timeline.
+# Save the terminal output to a file and run:
+#   python3 tools/trace_decode.py log.txt
+#
+# Dump format (see traceDump() in shell_func.c):
+#   TRACE <count> <lost>
+#   T <task index> <name>
+#   E <time> <type> <task> <arg>      time is WTIMER0 B at 40 MHz
+#   END
+
+import sys
+
+CYCLES_PER_US = 40
+
+TYPES = {0: "SWITCH", 1: "SVC", 2: "WAKE", 3: "BLOCK", 4: "TICK", 5: "RETURN"}
+
+# svc numbers from kernel.c
+SVCS = {0: "YIELD", 1: "SLEEP", 2: "LOCK", 3: "UNLOCK", 4: "WAIT", 5: "POST",
+        6: "PI", 7: "SCHED", 8: "PREEMPT", 9: "REBOOT", 10: "PIDOF", 11: "IPCS",
+        12: "PS", 13: "PKILL", 14: "KILL", 15: "RUN", 16: "RESTART", 17: "TPRIO",
+        18: "TICKLESS", 19: "TDEADLINE", 20: "WAITPERIOD", 21: "TQUANTUM",
+        22: "PQUANTUM", 23: "TBUDGET", 24: "TRACE", 25: "WAITTIMEOUT", 26: "LOCKTIMEOUT",
+        27: "SETEVENTS", 28: "CLEAREVENTS", 29: "WAITEVENTS", 30: "SEND", 31: "RECEIVE",
+        32: "SENDWORD", 33: "ALLOCMAIL", 34: "FREEMAIL",
+        35: "NOTIFY", 36: "TAKENOTIFY", 37: "CONDWAIT", 38: "CONDSIGNAL", 39: "CONDBROADCAST",
+        40: "READLOCK", 41: "WRITELOCK", 42: "READUNLOCK", 43: "WRITEUNLOCK"}
+
+STATES = {0: "INVALID", 1: "UNRUN", 2: "READY", 3: "DELAYED", 4: "BLOCKED(SEM)",
+          5: "BLOCKED(MUTEX)", 6: "KILLED", 7: "THROTTLED", 8: "BLOCKED(EVENT)",
+          9: "BLOCKED(SEND)", 10: "BLOCKED(RECV)", 11: "BLOCKED(NOTIFY)",
+          12: "BLOCKED(COND)", 13: "BLOCKED(READ)", 14: "BLOCKED(WRITE)"}
+
+
+def parse(lines):
+    names = {}
+    events = []
+    lost = 0
+    for line in lines:
+        f = line.split()
+        if not f:
+            continue
+        if f[0] == "TRACE" and len(f) >= 3:
+            names = {}
+            events = []
+            lost = int(f[2])
+        elif f[0] == "T" and len(f) >= 3:
+            names[int(f[1])] = f[2]
+        elif f[0] == "E" and len(f) >= 5:
+            events.append((int(f[1], 16), int(f[2]), int(f[3]), int(f[4])))
+    return names, events, lost
+
+
+def describe(names, kind, task, arg):
+    name = names.get(task, "task%d" % task)
+    if kind == 0:
+        return "%-10s runs (was %s)" % (name, names.get(arg, "task%d" % arg))
+    if kind == 1:
+        return "%-10s svc %s" % (name, SVCS.get(arg, str(arg)))
+    if kind == 2:
+        return "%-10s ready" % name
+    if kind == 3:
+        return "%-10s %s" % (name, STATES.get(arg, str(arg)))
+    if kind == 4:
+        return "%-10s tick handler took %.2f us" % (name, arg / CYCLES_PER_US)
+    if kind == 5:
+        return "%-10s svc %s done" % (name, SVCS.get(arg, str(arg)))
+    return "%-10s ? %d" % (name, arg)
+
+
+def main():
+    if len(sys.argv) > 1:
+        with open(sys.argv[1]) as f:
+            lines = f.readlines()
+    else:
+        lines = sys.stdin.readlines()
+    names, events, lost = parse(lines)
+    if not events:
+        print("no trace events found")
+        return
+    if lost:
+        print("%d older events were overwritten" % lost)
+
+    start = events[0][0]
+    running = {}
+    last_switch = None
+    current = None
+    print("%12s  %-6s  %s" % ("time (us)", "event", "detail"))
+    for time, kind, task, arg in events:
+        t = ((time - start) & 0xFFFFFFFF) / CYCLES_PER_US
+        print("%12.2f  %-6s  %s" % (t, TYPES.get(kind, "?"), describe(names, kind, task, arg)))
+        if kind == 0:
+            if current is not None and last_switch is not None:
+                running[current] = running.get(current, 0) + t - last_switch
+            current = task
+            last_switch = t
+
+    if running:
+        total = sum(running.values())
+        print("\nrun time between the first and last switch")
+        for task, us in sorted(running.items(), key=lambda x: -x[1]):
+            print("  %-16s %10.2f us  %5.1f%%" % (names.get(task, "task%d" % task), us, 100.0 * us / total))
+
+
+if __name__ == "__main__":
+    main()
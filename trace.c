@@ -0,0 +1,73 @@
+// Scheduler trace functions
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "port.h"
+#include "trace.h"
+
+// ring of the last TRACE_SIZE events
+// only written at the kernel priority: from svc and systick, or from pendsv and the FromIsr
+// functions inside the kernel critical section (see PORT_ENTER_CRITICAL), so no two writers
+// nest, and only read by the TRACE service call, so no locking is needed
+TRACE_EVENT traceRing[TRACE_SIZE];
+uint32_t traceHead = 0;                // total events written since start
+bool traceOn = false;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// free running WTIMER0 B as the trace time base (A measures task run time)
+void initTrace(void)
+{
+    portTraceTimerInit();
+    traceHead = 0;
+    traceOn = false;
+}
+
+void traceRecord(uint8_t type, uint8_t task, uint16_t arg)
+{
+    TRACE_EVENT *e = &traceRing[traceHead & (TRACE_SIZE - 1)];
+    e->time = PORT_TRACE_TIME();
+    e->type = type;
+    e->task = task;
+    e->arg = arg;
+    traceHead++;
+}
+
+// start, stop or copy out the ring (oldest event first)
+void traceControl(uint8_t command, TRACE_INFO *info)
+{
+    uint32_t i;
+    uint32_t first;
+    switch(command)
+    {
+    case TRACE_START:
+        traceHead = 0;
+        traceOn = true;
+        break;
+    case TRACE_STOP:
+        traceOn = false;
+        break;
+    case TRACE_DUMP:
+        info->count = (traceHead < TRACE_SIZE) ? traceHead : TRACE_SIZE;
+        info->lost = traceHead - info->count;
+        first = traceHead - info->count;
+        for(i = 0; i < info->count; i++)
+        {
+            info->events[i] = traceRing[(first + i) & (TRACE_SIZE - 1)];
+        }
+        break;
+    }
+}
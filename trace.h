@@ -0,0 +1,64 @@
+// Scheduler trace functions
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TRACE_SIZE 64                  // events kept in the ring (power of 2)
+
+// event types
+#define TRACE_SWITCH 0                 // task dispatched, arg = previous task
+#define TRACE_SVC    1                 // service call entered, arg = svc number
+#define TRACE_WAKE   2                 // task made ready
+#define TRACE_BLOCK  3                 // task left the ready queue, arg = new state
+#define TRACE_TICK   4                 // systick that woke or switched a task ended, arg = its cycles (max 0xFFFF)
+#define TRACE_RETURN 5                 // service call finished, arg = svc number
+
+// trace commands for the TRACE service call
+#define TRACE_STOP   0
+#define TRACE_START  1
+#define TRACE_DUMP   2
+
+typedef struct _TRACE_EVENT
+{
+    uint32_t time;                     // WTIMER0 B free running count (40 MHz)
+    uint8_t type;                      // see TRACE_ values above
+    uint8_t task;                      // tcb index
+    uint16_t arg;
+} TRACE_EVENT;
+
+typedef struct _TRACE_INFO
+{
+    TRACE_EVENT events[TRACE_SIZE];    // oldest first
+    uint32_t count;                    // valid events in events[]
+    uint32_t lost;                     // events overwritten since the trace was started
+} TRACE_INFO;
+
+extern bool traceOn;
+extern uint32_t traceHead;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initTrace(void);
+void traceRecord(uint8_t type, uint8_t task, uint16_t arg);
+void traceControl(uint8_t command, TRACE_INFO *info);
+
+// cheap enough to leave in the scheduler paths, nothing is done while tracing is off
+#define traceEvent(type, task, arg) do { if(traceOn) traceRecord((type), (task), (arg)); } while(0)
+
+#endif